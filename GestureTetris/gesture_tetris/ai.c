@@ -0,0 +1,266 @@
+#include "ai.h"
+#include "rotation.h"
+
+//heuristic weights, higher scores are better
+#define WEIGHT_HEIGHT -51
+#define WEIGHT_LINES 76
+#define WEIGHT_HOLES -36
+#define WEIGHT_BUMPINESS -18
+#define WEIGHT_WELLS -10
+
+//score of a board the next piece cannot be placed on
+#define SCORE_LOST -1000000
+
+//every rotation times every column the piece can reach
+#define MAX_PLACEMENTS (4 * (WIDTH + BOARD_PAD + 1))
+
+typedef struct {
+  piece_state piece;    //where the piece lands
+  int turns;            //quarter turns at the spawn
+  int slide;            //columns moved after turning
+} placement;
+
+typedef struct {
+  unsigned long long key;
+  int score;
+  bool used;
+} cache_entry;
+
+static const input_t turn_inputs[4] = {INPUT_NONE, INPUT_ROTATE_CW, INPUT_ROTATE_180, INPUT_ROTATE_CCW};
+
+//Zobrist keys. A row's key for any 10-bit mask is split into the keys of its low
+//and high five cells, so hashing a board is two lookups per occupied row.
+static unsigned long long row_keys_lo[HEIGHT][32];
+static unsigned long long row_keys_hi[HEIGHT][32];
+static unsigned long long piece_keys[NUM_PIECES];
+
+static cache_entry cache[AI_CACHE_SIZE];
+static ai_stats_t stats;
+
+static unsigned long long random_key(unsigned long long* state) {
+  //xorshift64, any fixed seed works as long as it never changes between runs
+  unsigned long long x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  *state = x;
+  return x;
+}
+
+void ai_init(void) {
+  unsigned long long state = 0x9E3779B97F4A7C15ULL;
+  for(int y = 0; y < HEIGHT; y++) {
+    unsigned long long cell_keys[WIDTH];
+    for(int x = 0; x < WIDTH; x++) {
+      cell_keys[x] = random_key(&state);
+    }
+    //key of a mask is the xor of the keys of its cells
+    for(int mask = 0; mask < 32; mask++) {
+      row_keys_lo[y][mask] = row_keys_hi[y][mask] = 0;
+      for(int x = 0; x < 5; x++) {
+        if(mask & (1 << x)) {
+          row_keys_lo[y][mask] ^= cell_keys[x];
+          row_keys_hi[y][mask] ^= cell_keys[x + 5];
+        }
+      }
+    }
+  }
+  for(int i = 0; i < NUM_PIECES; i++) {
+    piece_keys[i] = random_key(&state);
+  }
+  for(int i = 0; i < AI_CACHE_SIZE; i++) {
+    cache[i].used = false;
+  }
+  stats.hits = stats.misses = 0;
+}
+
+unsigned long long ai_hash(const board_t* board) {
+  unsigned long long hash = 0;
+  for(int y = HEIGHT - board->height; y < HEIGHT; y++) {
+    unsigned int mask = (board->rows[y] >> BOARD_PAD) & ((1 << WIDTH) - 1);
+    hash ^= row_keys_lo[y][mask & 31] ^ row_keys_hi[y][mask >> 5];
+  }
+  return hash;
+}
+
+ai_stats_t ai_get_stats(void) {
+  return stats;
+}
+
+static bool cache_find(unsigned long long key, int* score) {
+  cache_entry* entry = &cache[key & (AI_CACHE_SIZE - 1)];
+  if(entry->used && entry->key == key) {
+    stats.hits++;
+    *score = entry->score;
+    return true;
+  }
+  stats.misses++;
+  return false;
+}
+
+//newest entry wins its slot
+static void cache_store(unsigned long long key, int score) {
+  cache_entry* entry = &cache[key & (AI_CACHE_SIZE - 1)];
+  entry->key = key;
+  entry->score = score;
+  entry->used = true;
+}
+
+//Scores a board from its column heights and fill counters without scanning cells.
+//Every cell under a column's top that is not filled is a hole, so the hole count is
+//the sum of the heights minus the filled cells.
+int ai_evaluate(const board_t* board, int lines) {
+  int height = 0, filled = 0, bumpiness = 0, wells = 0;
+  for(int x = 0; x < WIDTH; x++) {
+    int h = board->col_height[x];
+    height += h;
+    if(x > 0) {
+      int step = h - board->col_height[x - 1];
+      bumpiness += step < 0 ? -step : step;
+    }
+    //depth below the lower neighbour, walls count as full height
+    int left = x > 0 ? board->col_height[x - 1] : HEIGHT;
+    int right = x < WIDTH - 1 ? board->col_height[x + 1] : HEIGHT;
+    int rim = left < right ? left : right;
+    if(rim > h + 1) {
+      wells += rim - h - 1;
+    }
+  }
+  for(int y = HEIGHT - board->height; y < HEIGHT; y++) {
+    filled += board->row_fill[y];
+  }
+  return WEIGHT_HEIGHT * height + WEIGHT_LINES * lines + WEIGHT_HOLES * (height - filled)
+    + WEIGHT_BUMPINESS * bumpiness + WEIGHT_WELLS * wells;
+}
+
+//Lists every placement reachable by turning at the start, sliding and dropping
+static int enumerate(const board_t* board, piece_state start, placement* list) {
+  int count = 0;
+  for(int turns = 0; turns < 4; turns++) {
+    piece_state turned = start;
+    if(turns && !rotate_piece(board, &turned, turns)) {
+      continue;
+    }
+    const piece_geometry* geom = &piece_table[turned.num][turned.rot];
+    //slide left from where the rotation left the piece, then right
+    for(int dir = -1; dir <= 1; dir += 2) {
+      piece_state piece = turned;
+      if(dir > 0) {
+        piece.x++;
+      }
+      while(!board_collides(board, geom, piece.x, piece.y)) {
+        list[count].piece = piece;
+        list[count].piece.y += board_drop_distance(board, geom, piece.x, piece.y);
+        list[count].turns = turns;
+        list[count].slide = piece.x - turned.x;
+        count++;
+        piece.x += dir;
+      }
+    }
+  }
+  return count;
+}
+
+//Locks a placement into board and returns the number of lines it cleared
+static int drop(board_t* board, const placement* p) {
+  const piece_geometry* geom = &piece_table[p->piece.num][p->piece.rot];
+  unsigned int lines = board_place(board, geom, p->piece.x, p->piece.y, p->piece.num + 1);
+  int count = 0;
+  if(lines) {
+    board_clear_lines(board, lines);
+    for(; lines; lines &= lines - 1) {
+      count++;
+    }
+  }
+  return count;
+}
+
+//Heuristic score of a board on its own, cached by its hash
+static int score_board(const board_t* board) {
+  unsigned long long key = ai_hash(board);
+  int score;
+  if(!cache_find(key, &score)) {
+    score = ai_evaluate(board, 0);
+    cache_store(key, score);
+  }
+  return score;
+}
+
+//Best score the next piece can reach on board. Boards that several first placements
+//lead to are searched once, keyed by the board hash mixed with the piece.
+static int best_reply(const board_t* board, int num) {
+  unsigned long long key = ai_hash(board) ^ piece_keys[num];
+  int best;
+  if(cache_find(key, &best)) {
+    return best;
+  }
+  piece_state spawn = {num, SPAWN_X, SPAWN_Y, 0};
+  placement list[MAX_PLACEMENTS];
+  int count = enumerate(board, spawn, list);
+  best = SCORE_LOST;
+  for(int i = 0; i < count; i++) {
+    board_t after = *board;
+    int lines = drop(&after, &list[i]);
+    if(board_topped_out(&after)) {
+      continue;
+    }
+    int score = WEIGHT_LINES * lines + score_board(&after);
+    if(score > best) {
+      best = score;
+    }
+  }
+  cache_store(key, best);
+  return best;
+}
+
+static void make_plan(ai_plan_t* plan, int turns, int slide) {
+  plan->count = 0;
+  if(turns) {
+    plan->moves[plan->count++] = turn_inputs[turns];
+  }
+  for(; slide < 0; slide++) {
+    plan->moves[plan->count++] = INPUT_LEFT;
+  }
+  for(; slide > 0; slide--) {
+    plan->moves[plan->count++] = INPUT_RIGHT;
+  }
+  plan->moves[plan->count++] = INPUT_HARD_DROP;
+}
+
+//Plans the placement that leaves the best board for the current piece alone. Touches
+//no cache or counters, so several threads can call it at once.
+bool ai_choose_greedy(const game_state_t* state, ai_plan_t* plan) {
+  placement list[MAX_PLACEMENTS];
+  int count = enumerate(&state->board, state->cur_piece, list);
+  int best = 0;
+  for(int i = 0; i < count; i++) {
+    board_t after = state->board;
+    int lines = drop(&after, &list[i]);
+    int score = board_topped_out(&after) ? SCORE_LOST : ai_evaluate(&after, lines);
+    if(i == 0 || score > best) {
+      best = score;
+      make_plan(plan, list[i].turns, list[i].slide);
+    }
+  }
+  return count > 0;
+}
+
+//Fills plan with the inputs that take the current piece to the placement that leaves
+//the best board after the next piece is placed as well.
+//Returns false when the piece cannot move at all.
+bool ai_choose(const game_state_t* state, ai_plan_t* plan) {
+  placement list[MAX_PLACEMENTS];
+  int count = enumerate(&state->board, state->cur_piece, list);
+  int next = next_piece(state, 0);
+  int best = 0;
+  for(int i = 0; i < count; i++) {
+    board_t after = state->board;
+    int lines = drop(&after, &list[i]);
+    int score = board_topped_out(&after) ? SCORE_LOST : WEIGHT_LINES * lines + best_reply(&after, next);
+    if(i == 0 || score > best) {
+      best = score;
+      make_plan(plan, list[i].turns, list[i].slide);
+    }
+  }
+  return count > 0;
+}
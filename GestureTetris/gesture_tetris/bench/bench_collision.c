@@ -0,0 +1,108 @@
+// Host microbenchmark: collision queries per second on the old byte grid
+// versus the bitboard in board.c. Build and run with `make bench`.
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "board.h"
+
+#define QUERIES 20000000
+#define NQUERY 4096
+
+typedef struct {
+  int num;
+  int rot;
+  int x;
+  int y;
+} query;
+
+static const rot_state states[NUM_PIECES][4] = {
+  {I_one, I_two, I_three, I_four},
+  {Z_one, Z_two, Z_three, Z_four},
+  {J_one, J_two, J_three, J_four},
+  {L_one, L_two, L_three, L_four},
+  {O_one, O_two, O_three, O_four},
+  {S_one, S_two, S_three, S_four},
+  {T_one, T_two, T_three, T_four},
+};
+
+static char grid[HEIGHT][WIDTH];
+static board_t board;
+static query queries[NQUERY];
+
+//the byte grid collision check game.c used before the bitboard
+static bool grid_collides(const rot_state state, int x, int y) {
+  for(int piece_y = 0; piece_y < 4; piece_y++) {
+    for(int piece_x = 0; piece_x < 4; piece_x++) {
+      if(state[piece_y][piece_x]) {
+        int board_x = x + piece_x;
+        int board_y = y + piece_y;
+        if(board_y >= HEIGHT || board_y < 0 || board_x >= WIDTH || board_x < 0) {
+          return true;
+        }
+        if(grid[board_y][board_x]) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+static double seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(void) {
+  srand(107);
+  board_init(&board);
+
+  //fill the bottom half of the board with a ragged stack, one hole per row
+  for(int y = HEIGHT / 2; y < HEIGHT; y++) {
+    int hole = rand() % WIDTH;
+    for(int x = 0; x < WIDTH; x++) {
+      if(x != hole && rand() % 4) {
+        grid[y][x] = 1;
+        board.rows[y] |= 1 << (x + BOARD_PAD);
+        board.cells[y][x] = 1;
+      }
+    }
+  }
+
+  for(int i = 0; i < NQUERY; i++) {
+    queries[i].num = rand() % NUM_PIECES;
+    queries[i].rot = rand() % 4;
+    queries[i].x = rand() % (WIDTH + 2) - 2;
+    queries[i].y = rand() % HEIGHT;
+  }
+
+  //both sides must agree before their speed means anything
+  for(int i = 0; i < NQUERY; i++) {
+    query q = queries[i];
+    if(grid_collides(states[q.num][q.rot], q.x, q.y) != board_collides(&board, &piece_table[q.num][q.rot], q.x, q.y)) {
+      printf("mismatch: piece %d rot %d at (%d, %d)\n", q.num, q.rot, q.x, q.y);
+      return 1;
+    }
+  }
+
+  volatile int hits = 0;
+  double start = seconds();
+  for(int i = 0; i < QUERIES; i++) {
+    query q = queries[i % NQUERY];
+    hits += grid_collides(states[q.num][q.rot], q.x, q.y);
+  }
+  double grid_time = seconds() - start;
+
+  start = seconds();
+  for(int i = 0; i < QUERIES; i++) {
+    query q = queries[i % NQUERY];
+    hits += board_collides(&board, &piece_table[q.num][q.rot], q.x, q.y);
+  }
+  double board_time = seconds() - start;
+
+  printf("grid:     %6.1f M queries/s\n", QUERIES / grid_time / 1e6);
+  printf("bitboard: %6.1f M queries/s\n", QUERIES / board_time / 1e6);
+  printf("speedup:  %6.2fx\n", grid_time / board_time);
+  return 0;
+}
@@ -0,0 +1,210 @@
+// Pi benchmark: rectangle fill rate in megapixels per second, for a board cell and
+// for the whole screen, with the column-major loop gl_draw_rect used before and with
+// the row-major span fill in gl.c, and for a cell copied from a prepared image. Build
+// and install with `make bench_fill`, it reports over the UART. gl.c comes from
+// ../gpu_test's libmypi.a, which the build brings up to date first. Before timing it
+// checks the store-multiple paths gl.c uses on the Pi against plain per-pixel
+// drawing, and it times nothing if they disagree.
+#include "gl.h"
+#include "glextra.h"
+#include "printf.h"
+#include "timer.h"
+#include "uart.h"
+
+#define WIDTH 640
+#define HEIGHT 480
+#define CELL 50
+
+//microseconds each measurement runs for at least
+#define RUN_US 500000
+
+//random blocks drawn and checked of each kind before timing
+#define CHECKS 400
+
+//pixels around each checked block that must be left alone
+#define MARGIN 9
+
+//the fill gl_draw_rect did before, a column at a time with a call for each bound
+static void column_fill(int x, int y, int w, int h, color_t c) {
+  unsigned int (*pixels)[fb_get_pitch() / 4] = fb_get_draw_buffer();
+  int xBound = x + w < gl_get_width() ? x + w : gl_get_width();
+  int yBound = y + h < gl_get_height() ? y + h : gl_get_height();
+  for(int xPos = x; xPos < xBound; xPos++) {
+    for(int yPos = y; yPos < yBound; yPos++) {
+      pixels[yPos][xPos] = c;
+    }
+  }
+}
+
+//CELL by CELL, the rest lets a check start the image off a 32-byte boundary
+static color_t tile[CELL * CELL + 8];
+
+static unsigned int seed = 1;
+static unsigned int failures;
+
+static unsigned int next_random(void) {
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+static int random_below(int n) {
+  return next_random() % n;
+}
+
+//A position that leaves a block of up to 2 * CELL hanging off either edge
+static int random_position(int size) {
+  return random_below(size + 3 * CELL) - 2 * CELL;
+}
+
+static bool in_block(int x, int y, int bx, int by, int w, int h) {
+  return x >= bx && y >= by && x < bx + w && y < by + h;
+}
+
+//Paints the block and MARGIN around it one pixel at a time, the area a check reads
+static void paint_around(int x, int y, int w, int h, color_t c) {
+  for(int yy = y - MARGIN; yy < y + h + MARGIN; yy++) {
+    for(int xx = x - MARGIN; xx < x + w + MARGIN; xx++) {
+      gl_draw_pixel(xx, yy, c);
+    }
+  }
+}
+
+static void expect(const char* what, int x, int y, color_t want) {
+  color_t got = gl_read_pixel(x, y);
+  if(got != want && failures++ < 10) {
+    printf("%s wrong at (%d, %d): %08x not %08x\n", what, x, y, got, want);
+  }
+}
+
+//The screen pixels of the block and MARGIN around it, so the loops skip what is off it
+#define FOR_AROUND(x, y, w, h) \
+  for(int yy = (y) - MARGIN < 0 ? 0 : (y) - MARGIN; yy < (y) + (h) + MARGIN && yy < HEIGHT; yy++) \
+    for(int xx = (x) - MARGIN < 0 ? 0 : (x) - MARGIN; xx < (x) + (w) + MARGIN && xx < WIDTH; xx++)
+
+static void check_rect(void) {
+  int x = random_position(WIDTH), y = random_position(HEIGHT);
+  int w = random_below(2 * CELL), h = random_below(2 * CELL);
+  color_t c = next_random(), bg = ~c;
+  paint_around(x, y, w, h, bg);
+  gl_draw_rect(x, y, w, h, c);
+  FOR_AROUND(x, y, w, h) {
+    expect("rect", xx, yy, in_block(xx, yy, x, y, w, h) ? c : bg);
+  }
+}
+
+//the image starts up to 7 words into tile, so its rows sit at every alignment
+static void check_image(void) {
+  int x = random_position(WIDTH), y = random_position(HEIGHT);
+  int w = random_below(CELL), h = random_below(CELL);
+  const color_t* image = tile + random_below(8);
+  paint_around(x, y, w, h, GL_BLACK);
+  gl_draw_image(x, y, w, h, image);
+  FOR_AROUND(x, y, w, h) {
+    expect("image", xx, yy, in_block(xx, yy, x, y, w, h) ? image[(yy - y) * w + xx - x] : GL_BLACK);
+  }
+}
+
+//A block of source, which may hang off it too, blitted to the screen opaque or keyed
+static void check_blit(gl_surface_t* source) {
+  int x = random_position(WIDTH), y = random_position(HEIGHT);
+  int sx = random_below(source->width + 16) - 8, sy = random_below(source->height + 16) - 8;
+  int w = random_below(2 * CELL), h = random_below(2 * CELL);
+  source->transparent = random_below(2);
+  paint_around(x, y, w, h, GL_WHITE);
+  gl_blit(NULL, x, y, source, sx, sy, w, h);
+  FOR_AROUND(x, y, w, h) {
+    color_t want = GL_WHITE;
+    int fx = sx + xx - x, fy = sy + yy - y;
+    if(in_block(xx, yy, x, y, w, h) && in_block(fx, fy, 0, 0, source->width, source->height)) {
+      color_t c = source->pixels[fy * (source->pitch / 4) + fx];
+      if(!source->transparent || c != source->transparent_color) {
+        want = c;
+      }
+    }
+    expect(source->transparent ? "keyed blit" : "blit", xx, yy, want);
+  }
+}
+
+//Every fill and copy path against the per-pixel drawing above. Returns whether they
+//all agree.
+static bool verify(void) {
+  gl_clear(GL_RED);
+  for(int y = 0; y < HEIGHT; y++) {
+    for(int x = 0; x < WIDTH; x++) {
+      expect("clear", x, y, GL_RED);
+    }
+  }
+  for(int i = 0; i < CHECKS; i++) {
+    check_rect();
+  }
+  for(int i = 0; i < CELL * CELL + 8; i++) {
+    tile[i] = gl_color(i, i >> 3, i >> 6);
+  }
+  for(int i = 0; i < CHECKS; i++) {
+    check_image();
+  }
+  //runs of a few pixels between the keyed ones
+  gl_surface_t* source = gl_surface_create(2 * CELL - 3, 2 * CELL - 5);
+  for(int y = 0; y < source->height; y++) {
+    for(int x = 0; x < source->width; x++) {
+      source->pixels[y * (source->pitch / 4) + x] = random_below(6) ? next_random() | 1 : 0;
+    }
+  }
+  source->transparent_color = 0;
+  for(int i = 0; i < CHECKS; i++) {
+    check_blit(source);
+  }
+  gl_surface_free(source);
+  if(failures) {
+    printf("%d pixels wrong, not timing\n", failures);
+  }
+  return !failures;
+}
+
+//a cell copied from a tile, as the board draws its pieces
+static void tile_blit(int x, int y, int w, int h, color_t c) {
+  gl_draw_image(x, y, w, h, tile);
+}
+
+//Fills w by h rectangles across the screen until RUN_US is up, then prints the rate
+//to a tenth of a megapixel per second, which is pixels per microsecond
+static void measure(const char* name, void (*fill)(int, int, int, int, color_t), int w, int h) {
+  unsigned int pixels = 0, n = 0;
+  unsigned int start = timer_get_ticks(), elapsed;
+  do {
+    int x = (n * 7 * CELL) % (WIDTH - w + 1);
+    int y = (n * 3 * CELL) % (HEIGHT - h + 1);
+    fill(x, y, w, h, gl_color(n, n >> 2, n >> 4));
+    pixels += w * h;
+    n++;
+    elapsed = timer_get_ticks() - start;
+  } while(elapsed < RUN_US);
+  unsigned int tenths = (unsigned long long) pixels * 10 / elapsed;
+  printf("%s %dx%d: %d.%d Mpixel/s over %d fills\n", name, w, h, tenths / 10, tenths % 10, n);
+}
+
+void main(void) {
+  timer_init();
+  uart_init();
+  gl_init(WIDTH, HEIGHT, GL_SINGLEBUFFER);
+
+  //the fast paths must draw what the plain loops do before their speed means anything
+  if(!verify()) {
+    uart_putchar(EOT);
+    return;
+  }
+
+  measure("column", column_fill, CELL, CELL);
+  measure("span  ", gl_draw_rect, CELL, CELL);
+  measure("image ", tile_blit, CELL, CELL);
+  measure("column", column_fill, WIDTH, HEIGHT);
+  measure("span  ", gl_draw_rect, WIDTH, HEIGHT);
+  unsigned int start = timer_get_ticks();
+  for(int i = 0; i < 20; i++) {
+    gl_clear(gl_color(i, i, i));
+  }
+  unsigned int elapsed = timer_get_ticks() - start;
+  printf("gl_clear %dx%d: %d.%d Mpixel/s\n", WIDTH, HEIGHT,
+    (int) (20ULL * WIDTH * HEIGHT / elapsed), (int) (200ULL * WIDTH * HEIGHT / elapsed % 10));
+  uart_putchar(EOT);
+}
@@ -0,0 +1,192 @@
+#include "board.h"
+#include "strings.h"
+
+void board_init(board_t* board) {
+  for(int y = 0; y < HEIGHT; y++) {
+    board->rows[y] = ROW_EMPTY;
+  }
+  for(int y = HEIGHT; y < HEIGHT + BOARD_FLOOR; y++) {
+    board->rows[y] = ROW_FULL;
+  }
+  memset(board->cells, 0, WIDTH * HEIGHT);
+  memset(board->row_fill, 0, HEIGHT);
+  memset(board->col_height, 0, WIDTH);
+  board->height = 0;
+}
+
+//True if the piece overlaps a filled cell, a wall, the floor or the top of the board
+bool board_collides(const board_t* board, const piece_geometry* piece, int x, int y) {
+  if(x < -BOARD_PAD || x > WIDTH || y > HEIGHT) {
+    return true;
+  }
+  int shift = x + BOARD_PAD;
+  for(int piece_y = piece->top; piece_y <= piece->bottom; piece_y++) {
+    row_t mask = (row_t) piece->rows[piece_y] << shift;
+    if(y + piece_y < 0 || (board->rows[y + piece_y] & mask)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool board_is_line(const board_t* board, int y) {
+  return board->rows[y] == ROW_FULL;
+}
+
+//Writes the piece into the board, the caller must have checked it does not collide.
+//Keeps the fill counters and column heights current and returns a mask with
+//bit y set for every row this piece completed.
+unsigned int board_place(board_t* board, const piece_geometry* piece, int x, int y, char id) {
+  unsigned int lines = 0;
+  for(int piece_y = piece->top; piece_y <= piece->bottom; piece_y++) {
+    board->rows[y + piece_y] |= (row_t) piece->rows[piece_y] << (x + BOARD_PAD);
+  }
+  for(int i = 0; i < 4; i++) {
+    int cell_x = x + piece->cells[i][0];
+    int cell_y = y + piece->cells[i][1];
+    board->cells[cell_y][cell_x] = id;
+    if(++board->row_fill[cell_y] == WIDTH) {
+      lines |= 1 << cell_y;
+    }
+    if(HEIGHT - cell_y > board->col_height[cell_x]) {
+      board->col_height[cell_x] = HEIGHT - cell_y;
+    }
+  }
+  int top = HEIGHT - (y + piece->top);
+  if(top > board->height) {
+    board->height = top;
+  }
+  return lines;
+}
+
+//Rebuilds the column heights by walking down from the top of the stack until every
+//column has been seen
+static void update_heights(board_t* board) {
+  row_t seen = ROW_EMPTY;
+  memset(board->col_height, 0, WIDTH);
+  for(int y = HEIGHT - board->height; y < HEIGHT && seen != ROW_FULL; y++) {
+    row_t found = board->rows[y] & ~seen;
+    for(int x = 0; found; x++) {
+      if(found & (1 << (x + BOARD_PAD))) {
+        board->col_height[x] = HEIGHT - y;
+        found &= ~(1 << (x + BOARD_PAD));
+      }
+    }
+    seen |= board->rows[y];
+  }
+  board->height = 0;
+  for(int x = 0; x < WIDTH; x++) {
+    if(board->col_height[x] > board->height) {
+      board->height = board->col_height[x];
+    }
+  }
+}
+
+//Removes every row set in lines and drops the rows above them in a single sweep,
+//no matter how many rows were cleared or whether they were next to each other.
+//Returns the rows whose contents changed.
+row_range board_clear_lines(board_t* board, unsigned int lines) {
+  row_range dirty = {HEIGHT, -1};
+  if(!lines) {
+    return dirty;
+  }
+  int top = HEIGHT - board->height;
+  int bottom = HEIGHT - 1;
+  while(!(lines & (1 << bottom))) {
+    bottom--;
+  }
+  //rows under the lowest cleared row do not move
+  int dst = bottom;
+  for(int src = bottom; src >= top; src--) {
+    if(lines & (1 << src)) {
+      continue;
+    }
+    board->rows[dst] = board->rows[src];
+    board->row_fill[dst] = board->row_fill[src];
+    for(int x = 0; x < WIDTH; x++) {
+      board->cells[dst][x] = board->cells[src][x];
+    }
+    dst--;
+  }
+  //rows left above the compacted stack are now empty
+  for(int y = dst; y >= top; y--) {
+    board->rows[y] = ROW_EMPTY;
+    board->row_fill[y] = 0;
+    memset(board->cells[y], 0, WIDTH);
+  }
+  update_heights(board);
+  dirty.top = top;
+  dirty.bottom = bottom;
+  return dirty;
+}
+
+bool board_topped_out(const board_t* board) {
+  return board->height > HEIGHT - SPAWN_ROWS;
+}
+
+//Number of rows the piece can fall from (x, y) before it lands. While the piece is
+//above the stack this is read off the column heights in one pass, only a piece
+//tucked under an overhang walks down the row masks.
+int board_drop_distance(const board_t* board, const piece_geometry* piece, int x, int y) {
+  int distance = HEIGHT;
+  for(int piece_x = piece->left; piece_x <= piece->right; piece_x++) {
+    int surface = HEIGHT - board->col_height[x + piece_x];
+    int gap = surface - 1 - (y + piece->col_bottom[piece_x]);
+    if(gap < 0) {
+      //under an overhang, the column height says nothing about what is below
+      distance = 0;
+      while(!board_collides(board, piece, x, y + distance + 1)) {
+        distance++;
+      }
+      return distance;
+    }
+    if(gap < distance) {
+      distance = gap;
+    }
+  }
+  return distance;
+}
+
+//Rebuilds the fill counters and column heights after the rows were written directly
+void board_refresh(board_t* board) {
+  for(int y = 0; y < HEIGHT; y++) {
+    board->row_fill[y] = 0;
+    for(row_t found = board->rows[y] & ~ROW_EMPTY; found; found &= found - 1) {
+      board->row_fill[y]++;
+    }
+  }
+  board->height = HEIGHT;
+  update_heights(board);
+}
+
+//Pushes the stack up and fills the bottom rows with garbage, every column but hole.
+//Returns false if that pushed filled cells off the top of the board.
+bool board_add_garbage(board_t* board, int rows, int hole) {
+  bool fits = board->height + rows <= HEIGHT;
+  for(int y = 0; y < HEIGHT - rows; y++) {
+    board->rows[y] = board->rows[y + rows];
+    board->row_fill[y] = board->row_fill[y + rows];
+    for(int x = 0; x < WIDTH; x++) {
+      board->cells[y][x] = board->cells[y + rows][x];
+    }
+  }
+  for(int y = HEIGHT - rows; y < HEIGHT; y++) {
+    board->rows[y] = ROW_FULL & ~(1 << (hole + BOARD_PAD));
+    board->row_fill[y] = WIDTH - 1;
+    for(int x = 0; x < WIDTH; x++) {
+      board->cells[y][x] = x == hole ? 0 : CELL_GARBAGE;
+    }
+  }
+  board->height = 0;
+  for(int x = 0; x < WIDTH; x++) {
+    int h = board->col_height[x];
+    if(x != hole || h) {
+      h = h + rows > HEIGHT ? HEIGHT : h + rows;
+    }
+    board->col_height[x] = h;
+    if(h > board->height) {
+      board->height = h;
+    }
+  }
+  return fits;
+}
@@ -0,0 +1,277 @@
+#include "core.h"
+#include "rotation.h"
+
+//Rows per tick for each level, 16.16. Levels 1 to 16 follow the guideline curve of
+//(0.8 - (level - 1) * 0.007) ^ (level - 1) seconds per row at twice its speed, which
+//keeps level 1 at the two rows a second the game always had, then it climbs to 20G.
+static const unsigned int gravity_table[MAX_LEVEL - MIN_LEVEL + 1] = {
+  2185, 2755, 3536, 4621, 6150, 8338, 11517, 16214, 23269, 34053,
+  50831, 77417, 120338, 190967, 309485, 512373,
+  10 * GRAVITY_ONE, 15 * GRAVITY_ONE, MAX_GRAVITY, MAX_GRAVITY,
+};
+
+//Records a change to cur_piece, and for locks and clears the board rows it touched
+static void emit(game_state_t* state, event_type_t type, int top, int bottom, int lines) {
+  const piece_state* cur = &state->cur_piece;
+  event_t e = {type, cur->num, cur->rot, cur->x, cur->y, top, bottom, lines};
+  events_push(&state->events, &e);
+}
+
+//Points for clearing one to four rows at once, times the level
+static const unsigned int clear_points[5] = {0, 100, 300, 500, 800};
+
+//Lines to clear at each level before the next one starts
+static const unsigned char level_lines[MAX_LEVEL - MIN_LEVEL + 1] = {
+  10, 10, 10, 10, 10, 10, 10, 10, 10, 15,
+  15, 15, 15, 15, 20, 20, 20, 20, 20, 20,
+};
+
+static void spawn(game_state_t* state) {
+  state->cur_piece.num = randomizer_next(&state->randomizer);
+  state->cur_piece.rot = 0;
+  state->cur_piece.x = SPAWN_X;
+  state->cur_piece.y = SPAWN_Y;
+  state->fall = 0;
+  state->lock_timer = LOCK_TICKS;
+  state->lock_resets = MAX_LOCK_RESETS;
+  state->lowest_y = SPAWN_Y;
+  emit(state, EVENT_SPAWNED, 0, 0, 0);
+  if(!is_valid_state(state, SPAWN_X, SPAWN_Y, 0)) {
+    state->game_over = true;
+  }
+}
+
+void core_init(game_state_t* state, unsigned int seed) {
+  board_init(&state->board);
+  randomizer_init(&state->randomizer, seed);
+  state->tick = 0;
+  state->pieces = 0;
+  state->lines = 0;
+  state->score = 0;
+  state->garbage = 0;
+  state->garbage_hole = 0;
+  core_set_level(state, MIN_LEVEL);
+  state->game_over = false;
+  events_init(&state->events);
+  spawn(state);
+}
+
+//Takes effect on the next tick, the ARM timer keeps its rate at every level. The next
+//level starts once the level's lines have been cleared from here.
+void core_set_level(game_state_t* state, int level) {
+  if(level < MIN_LEVEL) {
+    level = MIN_LEVEL;
+  }
+  if(level > MAX_LEVEL) {
+    level = MAX_LEVEL;
+  }
+  state->level = level;
+  state->gravity = gravity_table[level - MIN_LEVEL];
+  state->goal = state->lines + level_lines[level - MIN_LEVEL];
+}
+
+//ammar
+bool is_valid_state(const game_state_t* state, int new_x, int new_y, int new_rot) {
+  return !board_collides(&state->board, &piece_table[state->cur_piece.num][new_rot], new_x, new_y);
+}
+
+//bay
+bool is_touching(const game_state_t* state) {
+  const piece_state* cur = &state->cur_piece;
+  return board_collides(&state->board, &piece_table[cur->num][cur->rot], cur->x, cur->y + 1);
+}
+//ammar
+//Checks if a line has been created at the given y value using the board
+bool is_line(const game_state_t* state, int y) {
+  return board_is_line(&state->board, y);
+}
+
+//Row the piece would lock on if dropped straight down, used by hard drop and the ghost piece
+int landing_y(const game_state_t* state, piece_state piece) {
+  return piece.y + board_drop_distance(&state->board, &piece_table[piece.num][piece.rot], piece.x, piece.y);
+}
+
+//Upcoming piece i places ahead, 0 spawns next
+int next_piece(const game_state_t* state, int i) {
+  return randomizer_peek(&state->randomizer, i);
+}
+
+//Hands the oldest change to a consumer. A resync carries the current piece and every
+//row, so whoever gets it can rebuild from that alone.
+bool core_next_event(game_state_t* state, event_t* e) {
+  if(!events_pop(&state->events, e)) {
+    return false;
+  }
+  if(e->type == EVENT_RESYNC) {
+    const piece_state* cur = &state->cur_piece;
+    *e = (event_t) {EVENT_RESYNC, cur->num, cur->rot, cur->x, cur->y, 0, HEIGHT - 1, 0};
+  }
+  return true;
+}
+
+//Bakes cur_piece into the board, clears the rows it completed and spawns next_piece
+static void lock_piece(game_state_t* state) {
+  piece_state* cur = &state->cur_piece;
+  const piece_geometry* locked = &piece_table[cur->num][cur->rot];
+  unsigned int lines = board_place(&state->board, locked, cur->x, cur->y, cur->num + 1);
+  emit(state, EVENT_LOCKED, cur->y + locked->top, cur->y + locked->bottom, 0);
+  state->pieces++;
+  if(lines) {
+    row_range cleared = board_clear_lines(&state->board, lines);
+    int count = 0;
+    for(; lines; lines &= lines - 1) {
+      count++;
+    }
+    state->lines += count;
+    emit(state, EVENT_CLEARED, cleared.top, cleared.bottom, count);
+    state->score += clear_points[count] * state->level;
+    //gravity picks up on the next tick, nothing touches the ARM timer
+    if(state->lines >= state->goal && state->level < MAX_LEVEL) {
+      core_set_level(state, state->level + 1);
+    }
+    emit(state, EVENT_SCORED, 0, 0, count);
+  }
+  if(state->garbage) {
+    bool fits = board_add_garbage(&state->board, state->garbage, state->garbage_hole);
+    emit(state, EVENT_GARBAGE, HEIGHT - state->board.height, HEIGHT - 1, state->garbage);
+    state->garbage = 0;
+    if(!fits) {
+      state->game_over = true;
+      return;
+    }
+  }
+  if(board_topped_out(&state->board)) {
+    state->game_over = true;
+    return;
+  }
+  spawn(state);
+}
+
+//A move or rotation that worked restarts the lock timer while resets are left
+static void moved(game_state_t* state) {
+  if(state->lock_timer < LOCK_TICKS && state->lock_resets > 0) {
+    state->lock_resets--;
+    state->lock_timer = LOCK_TICKS;
+  }
+}
+
+static void apply_input(game_state_t* state, input_t input) {
+  piece_state* cur = &state->cur_piece;
+  bool ok = false;
+  event_type_t type = EVENT_ROTATED;
+  switch (input) {
+    case INPUT_LEFT:
+      if(is_valid_state(state, cur->x - 1, cur->y, cur->rot)) {
+        cur->x--;
+        ok = true;
+        type = EVENT_MOVED;
+      }
+      break;
+    case INPUT_RIGHT:
+      if(is_valid_state(state, cur->x + 1, cur->y, cur->rot)) {
+        cur->x++;
+        ok = true;
+        type = EVENT_MOVED;
+      }
+      break;
+    case INPUT_ROTATE_CW:
+      ok = rotate_piece(&state->board, cur, TURN_CW);
+      break;
+    case INPUT_ROTATE_CCW:
+      ok = rotate_piece(&state->board, cur, TURN_CCW);
+      break;
+    case INPUT_ROTATE_180:
+      ok = rotate_piece(&state->board, cur, TURN_180);
+      break;
+    case INPUT_HARD_DROP: {
+      int rows = landing_y(state, *cur) - cur->y;
+      cur->y += rows;
+      if(rows) {
+        state->score += DROP_POINTS * rows;
+        emit(state, EVENT_SCORED, 0, 0, 0);
+      }
+      lock_piece(state);
+      break;
+    }
+    case INPUT_NONE:
+      break;
+  }
+  if(ok) {
+    moved(state);
+    emit(state, type, 0, 0, 0);
+  }
+}
+
+//Adds a tick of gravity and moves the piece the whole rows it has built up, clamped
+//to its landing distance, so 20G costs one drop distance lookup like level 1 does.
+//A piece resting on the stack counts down its lock timer instead.
+static void apply_gravity(game_state_t* state) {
+  piece_state* cur = &state->cur_piece;
+  int distance = board_drop_distance(&state->board, &piece_table[cur->num][cur->rot], cur->x, cur->y);
+  if(distance == 0) {
+    state->fall = 0;
+    if(--state->lock_timer <= 0) {
+      lock_piece(state);
+    }
+    return;
+  }
+  state->fall += state->gravity;
+  int rows = state->fall >> 16;
+  state->fall &= GRAVITY_ONE - 1;
+  if(rows >= distance) {
+    rows = distance;
+    state->fall = 0;
+  }
+  if(rows == 0) {
+    return;
+  }
+  cur->y += rows;
+  emit(state, EVENT_MOVED, 0, 0, 0);
+  //a new lowest row earns the piece a fresh lock timer and resets
+  if(cur->y > state->lowest_y) {
+    state->lowest_y = cur->y;
+    state->lock_timer = LOCK_TICKS;
+    state->lock_resets = MAX_LOCK_RESETS;
+  }
+}
+
+//Advances the game by one tick: applies the input, then gravity.
+//Everything the game does goes through here and depends only on the state and the input.
+void core_step(game_state_t* state, input_t input) {
+  if(state->game_over) {
+    return;
+  }
+  state->tick++;
+  apply_input(state, input);
+  if(!state->game_over) {
+    apply_gravity(state);
+  }
+}
+
+//Garbage from the other player rises under the stack when the current piece locks,
+//so it never shifts the board under a falling piece
+void core_queue_garbage(game_state_t* state, int rows, int hole) {
+  rows += state->garbage;
+  state->garbage = rows > HEIGHT ? HEIGHT : rows;
+  state->garbage_hole = hole;
+}
+
+//FNV-1a over the board and the fields that decide what happens next, two runs of the
+//same game agree on it tick for tick
+unsigned int core_hash(const game_state_t* state) {
+  unsigned int hash = 2166136261;
+  const unsigned char* bytes = (const unsigned char*) state->board.rows;
+  for(unsigned int i = 0; i < sizeof(state->board.rows); i++) {
+    hash = (hash ^ bytes[i]) * 16777619;
+  }
+  unsigned int fields[] = {state->tick, state->pieces, state->lines, state->score, state->goal,
+    state->garbage, state->garbage_hole,
+    state->randomizer.rng,
+    state->gravity, state->fall, state->lock_timer, state->lock_resets, state->lowest_y,
+    state->cur_piece.num, state->cur_piece.x, state->cur_piece.y, state->cur_piece.rot};
+  bytes = (const unsigned char*) fields;
+  for(unsigned int i = 0; i < sizeof(fields); i++) {
+    hash = (hash ^ bytes[i]) * 16777619;
+  }
+  return hash;
+}
@@ -0,0 +1,31 @@
+#include "events.h"
+
+//starts with a resync so consumers draw and count from the fresh state
+void events_init(event_queue_t* q) {
+  q->head = q->tail = 0;
+  q->resync = false;
+  q->events[q->tail++].type = EVENT_RESYNC;
+}
+
+//A full queue drops the record and owes a resync, nobody waits on the consumers
+void events_push(event_queue_t* q, const event_t* e) {
+  if(q->tail - q->head == EVENT_QUEUE) {
+    q->resync = true;
+    return;
+  }
+  q->events[q->tail++ % EVENT_QUEUE] = *e;
+}
+
+//Oldest record first. Once the queue is empty a lost record shows up as EVENT_RESYNC.
+bool events_pop(event_queue_t* q, event_t* e) {
+  if(q->head != q->tail) {
+    *e = q->events[q->head++ % EVENT_QUEUE];
+    return true;
+  }
+  if(q->resync) {
+    q->resync = false;
+    e->type = EVENT_RESYNC;
+    return true;
+  }
+  return false;
+}
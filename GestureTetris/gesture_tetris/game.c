@@ -2,164 +2,306 @@
 #include "ps2.h"
 #include "interrupts.h"
 #include "armtimer.h"
+#include "keyboard.h"
+#include "keyboardextra.h"
 #include "render.h"
-#include "strings.h"
+#include "ai.h"
+#include "stats.h"
+#include "snapshot.h"
+#include "replay.h"
+#include "versus.h"
+#include "serial.h"
 #include "piece.h"
 #include "gl.h"
-#include "malloc.h"
 #include "timer.h"
+#include "printf.h"
 
-//pieces
-piece I = {0xFF00FF00, {I_one, I_two, I_three, I_four}};
-piece Z = {0xFF00FF00, {Z_one, Z_two, Z_three, Z_four}};
-piece J = {0xFFFF0000, {J_one, J_two, J_three, J_four}};
-piece L = {0xFF0000AA, {L_one, L_two, L_three, L_four}};
-piece O = {0xFF00FFFF, {O_one, O_two, O_three, O_four}};
-piece S = {0xFF00FF00, {S_one, S_two, S_three, S_four}};
-piece T = {0xFFFF00FF, {T_one, T_two, T_three, T_four}};
+#define INPUT_QUEUE 16
+#define HISTORY 16
 
 //game state
-piece_state cur_piece;
-int next_piece;
+game_state_t game;
 
-static int fall_interval = 500000;
+//ticks counted by the timer interrupt and ticks the core has simulated
+static volatile unsigned int timer_ticks;
+static unsigned int sim_ticks;
 
-void game_init(void) {
-  graphics_init();
-  piece_map = malloc(7 * 4);
-  piece_map[0] = &I;
-  piece_map[1] = &Z;
-  piece_map[2] = &J;
-  piece_map[3] = &L;
-  piece_map[4] = &O;
-  piece_map[5] = &S;
-  piece_map[6] = &T;
-
-  cur_piece.num = random_piece();
-  next_piece = random_piece();
-  cur_piece.rot = 0;
-  cur_piece.x = 5;
-  cur_piece.y = 20;
-  memset(board, 0, WIDTH * HEIGHT);
-  armtimer_init(fall_interval);
-  armtimer_enable();
-  armtimer_enable_interrupts();
-  interrupts_attach_handler(handle_timer, INTERRUPTS_BASIC_ARM_TIMER_IRQ);
-}
+//key presses waiting for a tick, one is applied per tick
+static input_t inputs[INPUT_QUEUE];
+static unsigned int input_head, input_tail;
 
-//ammar
-bool is_valid_state(int new_x, int new_y, int new_rot) {
-  for(int piece_x = 0; piece_x < 4; piece_x++) {
-    for(int piece_y = 0; piece_y < 4; piece_y++) {
-      bool piece = piece_map[cur_piece.num]->states[cur_piece.rot][piece_x][piece_y];
-      //Check if touches other piece on board
-      if(piece && (board[new_x + piece_x][new_y + piece_y])){
-        printf("touch %d", board[new_x + piece_x][new_y + piece_y]);
-        return false;
-      }
-      //Check vertical bounds
-      if(piece && (new_y + piece_y >= HEIGHT || new_y + piece_y < 0)){
-          printf("vert");
-          return false;
-      }
-      //Check horizontal bounds
-      if(piece && (new_x + piece_x >= WIDTH || new_x + piece_x < 0)){
-          printf("horz");
-          return false;
-      }
-    }
+//counted from the core's change records
+static stats_t stats;
+
+//practice mode rewind, a snapshot as each piece spawns in a ring of the last HISTORY
+static snapshot_t history[HISTORY];
+static unsigned int history_head, history_len;
+static unsigned int history_pieces;
+
+//every input applied since the game or the last rewind started, dumped with d
+static replay_log_t replay;
+
+//versus mode, started with v, plays another Pi over the UART. Both games of the match
+//run here, opponent is the other Pi's as this one simulates it.
+static bool versus_mode;
+static link_t link;
+static versus_t versus;
+static game_state_t opponent;
+
+//autoplayer, toggled with p, and the piece it last planned for
+static bool autoplay;
+static unsigned int planned_piece;
+
+//key handle_input turns into each input, the autoplayer presses these like a player would
+static const char input_keys[] = {
+  [INPUT_LEFT] = PS2_KEY_ARROW_LEFT,
+  [INPUT_RIGHT] = PS2_KEY_ARROW_RIGHT,
+  [INPUT_ROTATE_CW] = PS2_KEY_ARROW_UP,
+  [INPUT_HARD_DROP] = PS2_KEY_ARROW_DOWN,
+  [INPUT_ROTATE_CCW] = 'z',
+  [INPUT_ROTATE_180] = 'a',
+};
+
+static void save_history(void) {
+  snapshot_save(&game, &history[history_head]);
+  history_head = (history_head + 1) % HISTORY;
+  if(history_len < HISTORY) {
+    history_len++;
   }
-  return true;
+  history_pieces = game.pieces;
 }
 
-//bay
-bool is_touching(void) {
-  for(int piece_x = 0; piece_x < 4; piece_x++) {
-    for(int piece_y = 0; piece_y < 4; piece_y++) {
-      if(piece_map[cur_piece.num]->states[cur_piece.rot][piece_y][piece_x]
-        && (board[cur_piece.y + 1 + piece_y][cur_piece.x + piece_x] || cur_piece.y + piece_y + 1 >= HEIGHT)) {
-          return true;
-      }
-    }
+//Takes back the last piece placed, the previous piece starts over from its spawn
+static void rewind_piece(void) {
+  if(history_len < 2 || versus_mode) {
+    return;
   }
-  return false;
-}
-//ammar
-//Checks if a line has been created at the given y value using the board
-bool is_line(int y) {
-    for(int i = 0; i < WIDTH; i++){
-        if(board[y][i] == 0)
-            return false;
-    }
-    return true;
+  history_head = (history_head + HISTORY - 1) % HISTORY;
+  history_len--;
+  snapshot_restore(&game, &history[(history_head + HISTORY - 1) % HISTORY]);
+  history_pieces = planned_piece = game.pieces;
+  input_head = input_tail;
+  replay_init(&replay, &game, replay.seed);
 }
 
-//Bakes cur_piece into the board and updates cur_piece to be next_piece and assigns new next_piece
-void bake(void) {
-  for(int piece_x = 0; piece_x < 4; piece_x++) {
-    for(int piece_y = 0; piece_y < 4; piece_y++) {
-      if(piece_map[cur_piece.num]->states[cur_piece.rot][piece_y][piece_x]) {
-        board[cur_piece.y + piece_y][cur_piece.x + piece_x] = cur_piece.num + 1;
-      }
-    }
+//Waits for the other Pi, a fresh match starts once both have pressed v. From here on
+//the UART carries frames, so the board stops being printed to it. The screen splits
+//to show the other Pi's board beside this one's, empty until the match starts.
+static void start_versus(void) {
+  if(versus_mode) {
+    return;
   }
-  cur_piece.num = next_piece;
-  next_piece = random_piece();
+  versus_mode = true;
+  render_uart_dump(false);
+  serial_init(&link);
+  input_head = input_tail;
+  planned_piece = game.pieces;
+  unsigned int seed = timer_get_ticks();
+  core_init(&opponent, seed);
+  graphics_init(2);
+  render_attach(0, &game.board);
+  render_attach(1, &opponent.board);
+  versus_init(&versus, &link, &game, &opponent, seed, timer_get_ticks());
+}
+
+void game_init(void) {
+  graphics_init(1);
+  render_attach(0, &game.board);
+  unsigned int seed = timer_get_ticks();
+  core_init(&game, seed);
+  replay_init(&replay, &game, seed);
+  ai_init();
+  stats_init(&stats);
+  timer_ticks = sim_ticks = 0;
+  input_head = input_tail = 0;
+  history_head = history_len = 0;
+  save_history();
+  armtimer_init(1000000 / TICKS_PER_SECOND);
+  armtimer_enable();
+  armtimer_enable_interrupts();
+  interrupts_attach_handler(handle_timer, INTERRUPTS_BASIC_ARM_TIMER_IRQ);
 }
 
 //bay
+//Only counts ticks, the main loop does the work so the keyboard interrupt is never held off
 bool handle_timer(unsigned int pc) {
   if(armtimer_check_and_clear_interrupt()) {
-    if(is_valid_state(cur_piece.x, cur_piece.y + 1, cur_piece.rot)) {
-      printf("moved down\n");
-      cur_piece.y++;
-      if(is_touching()) {
-        //bake shape into board
-        if(cur_piece.y < 2) {
-          printf("GAME OVER\n");
-          while(1);
-        }
-        bake();
-        draw_board();
-
-        cur_piece.y = 0;
-        //make next shape into current shape resetting x and y to top
-        //randomly choose next shape
-
-        if(is_line(cur_piece.y)) {
-          //clear line
-        }
-      }
-    } else {
-      bake();
-      draw_board();
-    }
-    draw_piece(cur_piece);
-
+    timer_ticks++;
     return true;
   }
   return false;
 }
 
-int random_piece(void) {
-  //really bad randomness probably
-  double rand = timer_get_ticks() & 0b111;
-  return (7.0 / 8.0) * rand;
-}
-
 //ammar
 void handle_input(char key) {
+  input_t input = INPUT_NONE;
   switch (key) {
     case PS2_KEY_ARROW_LEFT:
-      cur_piece.x--;
+      input = INPUT_LEFT;
       break;
     case PS2_KEY_ARROW_RIGHT:
-      cur_piece.x++;
+      input = INPUT_RIGHT;
       break;
     case PS2_KEY_ARROW_DOWN:
+      input = INPUT_HARD_DROP;
       break;
     case PS2_KEY_ARROW_UP:
-      cur_piece.rot = cur_piece.rot + 1 % 4;
+    case 'x':
+      input = INPUT_ROTATE_CW;
+      break;
+    case 'z':
+      input = INPUT_ROTATE_CCW;
+      break;
+    case 'a':
+      input = INPUT_ROTATE_180;
+      break;
+    case 'p':
+      autoplay = !autoplay;
+      planned_piece = game.pieces;
+      break;
+    case 'r':
+      rewind_piece();
+      break;
+    case 'd':
+      if(!versus_mode) {
+        replay_dump(&replay, &game);
+      }
       break;
+    case 'v':
+      start_versus();
+      break;
+  }
+  //drop the press if the queue is full rather than a queued one
+  if(input != INPUT_NONE && input_tail - input_head < INPUT_QUEUE) {
+    inputs[input_tail++ % INPUT_QUEUE] = input;
+  }
+}
+
+static void drain_input(void) {
+  key_event_t event;
+  while(keyboard_poll_event(&event)) {
+    if(event.action.what == KEY_PRESS) {
+      handle_input(event.key.ch);
+    }
+  }
+}
+
+//Plans each new piece once it has spawned and types the plan in through handle_input
+static void run_autoplay(void) {
+  //pieces counts locked pieces, so it changes exactly when a new piece spawns
+  if(!autoplay || planned_piece == game.pieces + 1 || input_head != input_tail) {
+    return;
+  }
+  planned_piece = game.pieces + 1;
+  ai_plan_t plan;
+  if(ai_choose(&game, &plan)) {
+    for(int i = 0; i < plan.count; i++) {
+      handle_input(input_keys[plan.moves[i]]);
+    }
+  }
+}
+
+//Runs the match for every tick the timer counted. A tick it has to wait out keeps
+//its key press for the next one.
+static void simulate_versus(void) {
+  unsigned int now = timer_ticks;
+  while(sim_ticks != now) {
+    input_t input = input_head != input_tail ? inputs[input_head % INPUT_QUEUE] : INPUT_NONE;
+    sim_ticks++;
+    if(versus_tick(&versus, input) && input != INPUT_NONE) {
+      input_head++;
+    }
+  }
+}
+
+//Steps the core once for every tick the timer counted since the last frame
+static void simulate(void) {
+  if(versus_mode) {
+    simulate_versus();
+    return;
+  }
+  unsigned int now = timer_ticks;
+  while(sim_ticks != now && !game.game_over) {
+    input_t input = INPUT_NONE;
+    if(input_head != input_tail) {
+      input = inputs[input_head++ % INPUT_QUEUE];
+      replay_record(&replay, &game, input);
+    }
+    core_step(&game, input);
+    sim_ticks++;
+    if(game.pieces != history_pieces && !game.game_over) {
+      save_history();
+    }
+  }
+}
+
+//Hands the changes a game recorded to its board on screen
+static void render_game(int view, game_state_t* state) {
+  event_t e;
+  while(core_next_event(state, &e)) {
+    render_event(view, &e);
+    if(state == &game) {
+      stats_event(&stats, &e);
+    }
+    if(e.type == EVENT_SCORED || e.type == EVENT_RESYNC) {
+      draw_score(view, state->score, state->level, state->lines);
+    }
+  }
+}
+
+//Hands each change the core recorded to the renderer and the stats, then draws
+//what changed into the back buffer and presents every board at once
+static void render(void) {
+  render_game(0, &game);
+  if(versus_mode) {
+    render_game(1, &opponent);
+  }
+  render_flush();
+}
+
+//One pass of the frame pipeline: drain input, simulate, render, present, then trade
+//inputs and heartbeats with the other Pi in versus mode
+void game_frame(void) {
+  drain_input();
+  run_autoplay();
+  simulate();
+  render();
+  if(versus_mode) {
+    versus_update(&versus, timer_get_ticks());
+  }
+}
+
+static bool finished(void) {
+  return versus_mode ? versus_over(&versus) : game.game_over;
+}
+
+void game_run(void) {
+  while(!finished()) {
+    game_frame();
+  }
+  if(versus_mode) {
+    //the other side needs our last inputs to settle the match before the UART goes
+    //back to text, a second is plenty
+    unsigned int start = timer_get_ticks();
+    while(!versus_flushed(&versus) && timer_get_ticks() - start < 1000000) {
+      versus_update(&versus, timer_get_ticks());
+    }
+    while(!link_tx_empty(&link)) {
+    }
+    versus_print(&versus, timer_get_ticks());
+  }
+  printf("GAME OVER\n");
+  printf("score %d level %d\n", game.score, game.level);
+  stats_print(&stats);
+  render_stats_t drawn = render_get_stats();
+  printf("render %d presents %d cells %d kpixels\n", drawn.presents, drawn.cells,
+    (int) (drawn.pixels / 1000));
+  //a versus game depends on the other player's garbage, so its log would not replay
+  if(!versus_mode) {
+    replay_dump(&replay, &game);
+  }
+  if(autoplay) {
+    ai_stats_t ai = ai_get_stats();
+    printf("ai cache %d hits %d misses\n", ai.hits, ai.misses);
   }
 }
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include "fb.h"
+#include "font.h"
+#include "fake_fb.h"
+
+//words of padding after each row
+#define PAD 8
+
+static unsigned int width, height, pitch, y_offset;
+static fb_mode_t mode;
+static unsigned int* memory;
+
+void fb_init(unsigned int w, unsigned int h, unsigned int depth_in_bytes, fb_mode_t m) {
+  width = w;
+  height = h;
+  pitch = w + PAD;
+  mode = m;
+  y_offset = 0;
+  size_t words = (size_t) pitch * h * (m == FB_DOUBLEBUFFER ? 2 : 1);
+  free(memory);
+  memory = malloc(words * 4);
+  for(size_t i = 0; i < words; i++) {
+    memory[i] = FAKE_FB_JUNK;
+  }
+}
+
+void fb_swap_buffer(void) {
+  if(mode == FB_DOUBLEBUFFER) {
+    y_offset = y_offset ? 0 : height;
+  }
+}
+
+//the half not on screen, as fb.c picks it
+void* fb_get_draw_buffer(void) {
+  return mode == FB_DOUBLEBUFFER && !y_offset ? memory + (size_t) pitch * height : memory;
+}
+
+const unsigned int* fake_fb_front(void) {
+  return memory + (size_t) pitch * y_offset;
+}
+
+unsigned int fb_get_width(void) {
+  return width;
+}
+
+unsigned int fb_get_height(void) {
+  return height;
+}
+
+unsigned int fb_get_depth(void) {
+  return 4;
+}
+
+unsigned int fb_get_pitch(void) {
+  return pitch * 4;
+}
+
+//strings.c has it on the Pi
+int min(int a, int b) {
+  return a < b ? a : b;
+}
+
+//8x14 glyphs with a pattern that differs from character to character
+size_t font_get_width(void) {
+  return 8;
+}
+
+size_t font_get_height(void) {
+  return 14;
+}
+
+size_t font_get_size(void) {
+  return 8 * 14;
+}
+
+bool font_get_char(char ch, unsigned char buf[], size_t buflen) {
+  for(size_t i = 0; i < buflen; i++) {
+    buf[i] = (ch * 7 + i) % 5 == 0;
+  }
+  return true;
+}
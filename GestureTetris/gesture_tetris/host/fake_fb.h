@@ -0,0 +1,13 @@
+#ifndef FAKE_FB_H
+#define FAKE_FB_H
+
+//An in-memory stand-in for the Pi framebuffer and font, so gl.c and the renderer run
+//on the host. Rows are padded past the width, as the GPU may pad them, and both
+//buffers start out full of JUNK so a pixel nobody drew stands out.
+
+#define FAKE_FB_JUNK 0x12345678
+
+//the buffer on screen, fb_get_pitch bytes to a row
+const unsigned int* fake_fb_front(void);
+
+#endif
@@ -0,0 +1,171 @@
+// Host check for the surface and blit code in gl.c: draws random rectangles, images
+// and blits, many of them hanging off an edge, into the in-memory framebuffer and
+// into surfaces, and compares every pixel with a plain per-pixel drawing of the same.
+// Row padding past the width must stay untouched. Build with `make check`, run as
+// ./host/gl_check [rounds].
+#include <stdio.h>
+#include <stdlib.h>
+#include "gl.h"
+#include "glextra.h"
+#include "fake_fb.h"
+
+#define MAX_SIDE 64
+
+static unsigned int bad;
+
+static void report(const char* what, int round, int x, int y, color_t got, color_t want) {
+  if(bad++ < 10) {
+    printf("round %d %s (%d, %d): got %08x want %08x\n", round, what, x, y, got, want);
+  }
+}
+
+static color_t surface_pixel(const gl_surface_t* s, int x, int y) {
+  return s->pixels[y * (s->pitch / 4) + x];
+}
+
+//the whole framebuffer against ref, w by h, and the padding after each row
+static void check_screen(const char* what, int round, const color_t* ref, int w, int h) {
+  const unsigned int* front = fake_fb_front();
+  int pitch = fb_get_pitch() / 4;
+  for(int y = 0; y < h; y++) {
+    for(int x = 0; x < pitch; x++) {
+      color_t want = x < w ? ref[y * w + x] : FAKE_FB_JUNK;
+      if(front[y * pitch + x] != want) {
+        report(what, round, x, y, front[y * pitch + x], want);
+        return;
+      }
+    }
+  }
+}
+
+//gl_clear and gl_draw_rect on a screen whose width is not a multiple of the burst
+static void check_rects(int round, int w, int h) {
+  color_t* ref = malloc(w * h * sizeof(color_t));
+  gl_init(w, h, GL_SINGLEBUFFER);
+  gl_clear(GL_AMBER);
+  for(int i = 0; i < w * h; i++) {
+    ref[i] = GL_AMBER;
+  }
+  for(int i = 0; i < 2000; i++) {
+    int x = rand() % (w + 40) - 20, y = rand() % (h + 40) - 20;
+    int rw = rand() % 60, rh = rand() % 60;
+    color_t c = rand();
+    gl_draw_rect(x, y, rw, rh, c);
+    for(int yy = y; yy < y + rh; yy++) {
+      for(int xx = x; xx < x + rw; xx++) {
+        if(xx >= 0 && yy >= 0 && xx < w && yy < h) {
+          ref[yy * w + xx] = c;
+        }
+      }
+    }
+  }
+  check_screen("rect", round, ref, w, h);
+  free(ref);
+}
+
+//gl_draw_image, clipped on every side
+static void check_images(int round, int w, int h) {
+  static color_t image[MAX_SIDE * MAX_SIDE];
+  color_t* ref = malloc(w * h * sizeof(color_t));
+  for(int i = 0; i < MAX_SIDE * MAX_SIDE; i++) {
+    image[i] = rand();
+  }
+  gl_init(w, h, GL_SINGLEBUFFER);
+  gl_clear(GL_BLACK);
+  for(int i = 0; i < w * h; i++) {
+    ref[i] = GL_BLACK;
+  }
+  for(int i = 0; i < 2000; i++) {
+    int x = rand() % (w + 40) - 20, y = rand() % (h + 40) - 20;
+    int iw = rand() % MAX_SIDE, ih = rand() % MAX_SIDE;
+    gl_draw_image(x, y, iw, ih, image);
+    for(int yy = y; yy < y + ih; yy++) {
+      for(int xx = x; xx < x + iw; xx++) {
+        if(xx >= 0 && yy >= 0 && xx < w && yy < h) {
+          ref[yy * w + xx] = image[(yy - y) * iw + xx - x];
+        }
+      }
+    }
+  }
+  check_screen("image", round, ref, w, h);
+  free(ref);
+}
+
+//One surface to surface blit with the block hanging off either side of either
+//surface, opaque or keyed, then freeing the target must send drawing back to the
+//framebuffer
+static void check_blit(int round) {
+  int sw = 1 + rand() % MAX_SIDE, sh = 1 + rand() % MAX_SIDE;
+  int dw = 1 + rand() % MAX_SIDE, dh = 1 + rand() % MAX_SIDE;
+  gl_surface_t* src = gl_surface_create(sw, sh);
+  gl_surface_t* dst = gl_surface_create(dw, dh);
+  if(((unsigned long) src->pixels & 31) || src->pitch % 32) {
+    report("alignment", round, sw, sh, (unsigned long) src->pixels & 31, src->pitch);
+  }
+  gl_set_target(src);
+  for(int y = 0; y < sh; y++) {
+    for(int x = 0; x < sw; x++) {
+      gl_draw_pixel(x, y, rand() % 4);
+    }
+  }
+  gl_set_target(dst);
+  gl_clear(GL_BLUE);
+  gl_draw_rect(-3, -3, 5, 5, GL_RED);
+  gl_set_target(NULL);
+
+  static color_t ref[MAX_SIDE][MAX_SIDE];
+  for(int y = 0; y < dh; y++) {
+    for(int x = 0; x < dw; x++) {
+      ref[y][x] = surface_pixel(dst, x, y);
+    }
+  }
+  src->transparent = rand() % 2;
+  src->transparent_color = 0;
+  int x = rand() % 80 - 20, y = rand() % 80 - 20;
+  int sx = rand() % 80 - 20, sy = rand() % 80 - 20;
+  int w = rand() % 70, h = rand() % 70;
+  gl_blit(dst, x, y, src, sx, sy, w, h);
+  for(int j = 0; j < h; j++) {
+    for(int i = 0; i < w; i++) {
+      if(sx + i < 0 || sy + j < 0 || sx + i >= sw || sy + j >= sh ||
+         x + i < 0 || y + j < 0 || x + i >= dw || y + j >= dh) {
+        continue;
+      }
+      color_t c = surface_pixel(src, sx + i, sy + j);
+      if(!src->transparent || c != src->transparent_color) {
+        ref[y + j][x + i] = c;
+      }
+    }
+  }
+  for(int yy = 0; yy < dh; yy++) {
+    for(int xx = 0; xx < dw; xx++) {
+      if(surface_pixel(dst, xx, yy) != ref[yy][xx]) {
+        report("blit", round, xx, yy, surface_pixel(dst, xx, yy), ref[yy][xx]);
+        yy = dh;
+        break;
+      }
+    }
+  }
+
+  gl_set_target(dst);
+  gl_surface_free(dst);
+  gl_draw_pixel(0, 0, GL_GREEN);
+  if(fake_fb_front()[0] != GL_GREEN) {
+    report("target", round, 0, 0, fake_fb_front()[0], GL_GREEN);
+  }
+  gl_surface_free(src);
+}
+
+int main(int argc, char** argv) {
+  int rounds = argc > 1 ? atoi(argv[1]) : 3000;
+  for(int round = 0; round < 3; round++) {
+    check_rects(round, 100 + round * 37, 90 + round * 11);
+    check_images(round, 100 + round * 37, 90 + round * 11);
+  }
+  gl_init(123, 77, GL_SINGLEBUFFER);
+  for(int round = 0; round < rounds; round++) {
+    check_blit(round);
+  }
+  printf("%d blits, %d bad\n", rounds, bad);
+  return bad != 0;
+}
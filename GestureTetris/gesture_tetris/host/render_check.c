@@ -0,0 +1,193 @@
+// Host check for the renderer: plays an autoplayed match through render.c and gl.c
+// on an in-memory framebuffer and after every render_flush compares each pixel of
+// the boards and panels on screen with a from-scratch drawing of the games. Both
+// buffers are checked as they come to the front, so a change one of them missed
+// shows up even when the other has it.
+// Build with `make check`, run as ./host/render_check [boards] [ticks] [ticks per
+// frame], where frames slower than ticks let several changes pile up per flush.
+#include <stdio.h>
+#include <stdlib.h>
+#include "core.h"
+#include "ai.h"
+#include "render.h"
+#include "rollback.h"
+#include "glextra.h"
+#include "fake_fb.h"
+
+//as render.c colors them
+static const color_t colors[NUM_PIECES + 2] = {
+  0xFF00FF00, 0xFF00FF00, 0xFFFF0000, 0xFF0000AA, 0xFF00FFFF, 0xFF00FF00, 0xFFFF00FF,
+  0xFF808080, 0xFF505050
+};
+
+static game_state_t games[MAX_VIEWS];
+//a piece shows from its spawn until it locks, a game that ends on a lock has none
+static bool piece_shown[MAX_VIEWS];
+static int boards, cell, stride;
+static gl_surface_t* panel;
+static unsigned int frames, bad;
+
+//Pixel (px, py) of a cell showing c: flat for empty and ghost cells, bevelled for
+//filled ones, lit from the top left
+static color_t cell_pixel(color_t c, bool bevelled, int px, int py) {
+  if(!bevelled) {
+    return c;
+  }
+  int bevel = cell / 10;
+  int lit = px < py ? px : py;
+  int shaded = cell - 1 - (px > py ? px : py);
+  if(lit < bevel && lit < shaded) {
+    return GL_BLACK | (((c & 0xFEFEFE) >> 1) + 0x7F7F7F);
+  }
+  if(shaded < bevel || lit < bevel) {
+    return GL_BLACK | ((c & 0xFEFEFE) >> 1);
+  }
+  return c;
+}
+
+static void report(int view, const char* what, int x, int y, color_t got, color_t want) {
+  if(bad++ < 10) {
+    printf("frame %d board %d %s (%d, %d): got %08x want %08x\n", frames, view, what, x, y, got, want);
+  }
+}
+
+static void check_board(int view, const unsigned int* front, int pitch) {
+  const game_state_t* g = &games[view];
+  color_t want[HEIGHT][WIDTH];
+  bool bevelled[HEIGHT][WIDTH];
+  for(int y = 0; y < HEIGHT; y++) {
+    for(int x = 0; x < WIDTH; x++) {
+      int c = g->board.cells[y][x];
+      want[y][x] = c ? colors[c - 1] : GL_BLACK;
+      bevelled[y][x] = c != 0;
+    }
+  }
+  piece_state p = g->cur_piece;
+  const piece_geometry* geom = &piece_table[p.num][p.rot];
+  int ghost_y = landing_y(g, p);
+  for(int i = 0; i < 4 * piece_shown[view]; i++) {
+    int x = p.x + geom->cells[i][0], y = ghost_y + geom->cells[i][1];
+    want[y][x] = GL_BLACK | ((colors[p.num] >> 2) & 0x3F3F3F);
+    bevelled[y][x] = false;
+  }
+  for(int i = 0; i < 4 * piece_shown[view]; i++) {
+    int x = p.x + geom->cells[i][0], y = p.y + geom->cells[i][1];
+    want[y][x] = colors[p.num];
+    bevelled[y][x] = true;
+  }
+  for(int y = 0; y < HEIGHT; y++) {
+    for(int x = 0; x < WIDTH; x++) {
+      for(int py = 0; py < cell; py++) {
+        const unsigned int* row = front + (y * cell + py) * pitch + view * stride + x * cell;
+        for(int px = 0; px < cell; px++) {
+          color_t expect = cell_pixel(want[y][x], bevelled[y][x], px, py);
+          if(row[px] != expect) {
+            report(view, "cell", x, y, row[px], expect);
+            goto next_cell;
+          }
+        }
+      }
+      next_cell:;
+    }
+  }
+}
+
+//the panel as render.c lays it out, drawn off screen to compare against
+static void check_panel(int view, const unsigned int* front, int pitch) {
+  const game_state_t* g = &games[view];
+  int line = gl_get_char_height() + 4;
+  char buf[16];
+  gl_set_target(panel);
+  gl_clear(GL_BLACK);
+  gl_draw_string(8, line, "SCORE", GL_WHITE);
+  snprintf(buf, sizeof(buf), "%d", g->score);
+  gl_draw_string(8, 2 * line, buf, GL_WHITE);
+  gl_draw_string(8, 3 * line, "LEVEL", GL_WHITE);
+  snprintf(buf, sizeof(buf), "%d", g->level);
+  gl_draw_string(8, 4 * line, buf, GL_WHITE);
+  gl_draw_string(8, 5 * line, "LINES", GL_WHITE);
+  snprintf(buf, sizeof(buf), "%d", g->lines);
+  gl_draw_string(8, 6 * line, buf, GL_WHITE);
+  gl_set_target(NULL);
+  for(int y = 0; y < panel->height; y++) {
+    const unsigned int* row = front + y * pitch + view * stride + WIDTH * cell;
+    for(int x = 0; x < panel->width; x++) {
+      color_t want = panel->pixels[y * panel->pitch / 4 + x];
+      if(row[x] != want) {
+        report(view, "panel", x, y, row[x], want);
+        return;
+      }
+    }
+  }
+}
+
+//one planned input per tick, planning again whenever a new piece spawns
+static input_t ai_input(const game_state_t* state, ai_plan_t* plan, int* next, unsigned int* planned) {
+  if(*planned != state->pieces + 1) {
+    *planned = state->pieces + 1;
+    *next = 0;
+    if(!ai_choose_greedy(state, plan)) {
+      plan->count = 0;
+    }
+  }
+  return *next < plan->count ? plan->moves[(*next)++] : INPUT_NONE;
+}
+
+int main(int argc, char** argv) {
+  boards = argc > 1 ? atoi(argv[1]) : 2;
+  int ticks = argc > 2 ? atoi(argv[2]) : 20000;
+  int frame_ticks = argc > 3 ? atoi(argv[3]) : 1;
+  if(boards < 1 || boards > MAX_VIEWS || frame_ticks < 1) {
+    printf("usage: %s [boards 1-%d] [ticks] [ticks per frame]\n", argv[0], MAX_VIEWS);
+    return 2;
+  }
+
+  //a match in lockstep with every input known at once, the second player slower
+  static rollback_t match;
+  rollback_init(&match, &games[0], &games[1], 0, 5);
+  graphics_init(boards);
+  render_uart_dump(false);
+  for(int v = 0; v < boards; v++) {
+    render_attach(v, &games[v].board);
+  }
+  cell = gl_get_height() / HEIGHT;
+  stride = gl_get_width() / boards;
+  panel = gl_surface_create(160, 7 * (gl_get_char_height() + 4));
+
+  ai_plan_t plans[2];
+  int next[2] = {0, 0};
+  unsigned int planned[2] = {0, 0};
+  for(int t = 0; t < ticks && !games[0].game_over && !games[1].game_over; t++) {
+    unsigned char remote = t % 4 ? INPUT_NONE : ai_input(&games[1], &plans[1], &next[1], &planned[1]);
+    rollback_receive(&match, t, &remote, 1);
+    match.acked = match.given;
+    rollback_tick(&match, ai_input(&games[0], &plans[0], &next[0], &planned[0]));
+    for(int v = 0; v < boards; v++) {
+      event_t e;
+      while(core_next_event(&games[v], &e)) {
+        render_event(v, &e);
+        if(e.type == EVENT_LOCKED || e.type == EVENT_SPAWNED || e.type == EVENT_RESYNC) {
+          piece_shown[v] = e.type != EVENT_LOCKED;
+        }
+        if(e.type == EVENT_SCORED || e.type == EVENT_RESYNC) {
+          draw_score(v, games[v].score, games[v].level, games[v].lines);
+        }
+      }
+    }
+    if(t % frame_ticks == frame_ticks - 1) {
+      render_flush();
+      for(int v = 0; v < boards; v++) {
+        check_board(v, fake_fb_front(), fb_get_pitch() / 4);
+        check_panel(v, fake_fb_front(), fb_get_pitch() / 4);
+      }
+      frames++;
+    }
+  }
+
+  render_stats_t stats = render_get_stats();
+  printf("%d boards, %d frames, %d presents, %d bad, lines %d and %d\n", boards, frames,
+    stats.presents, bad, games[0].lines, games[1].lines);
+  printf("%d cells painted, %llu pixels written, %llu a present\n", stats.cells,
+    stats.pixels, stats.pixels / (stats.presents ? stats.presents : 1));
+  return bad != 0;
+}
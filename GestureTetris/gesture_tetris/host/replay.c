@@ -0,0 +1,100 @@
+// Host replayer for input logs dumped over the UART: reads a log from a file or stdin,
+// plays it through the core and checks the state it ends in against the hash in the
+// dump. Build with `make host`, run as ./host/replay [dump], or as
+// ./host/replay record [seed] [pieces] to dump a log of an autoplayed game instead.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "core.h"
+#include "ai.h"
+#include "replay.h"
+
+static replay_log_t log_in;
+static game_state_t state;
+
+static double seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+//Plays a game with the greedy autoplayer, recording like game.c does, and dumps it
+static int record(unsigned int seed, unsigned int pieces) {
+  ai_plan_t plan;
+  int next = 0;
+  unsigned int planned = 0;
+  core_init(&state, seed);
+  replay_init(&log_in, &state, seed);
+  while(!state.game_over && state.pieces < pieces) {
+    if(planned != state.pieces + 1) {
+      planned = state.pieces + 1;
+      next = 0;
+      if(!ai_choose_greedy(&state, &plan)) {
+        plan.count = 0;
+      }
+    }
+    input_t input = next < plan.count ? plan.moves[next++] : INPUT_NONE;
+    if(input != INPUT_NONE) {
+      replay_record(&log_in, &state, input);
+    }
+    core_step(&state, input);
+  }
+  replay_dump(&log_in, &state);
+  return 0;
+}
+
+static int play(FILE* in) {
+  unsigned int seed, end_tick, hash, records;
+  if(fscanf(in, " REPLAY %x %x %x %x", &seed, &end_tick, &hash, &records) != 4) {
+    fprintf(stderr, "no REPLAY header\n");
+    return 2;
+  }
+  log_in.seed = seed;
+  for(int i = 0; i < SNAPSHOT_WORDS; i++) {
+    if(fscanf(in, " %x", &log_in.base.words[i]) != 1) {
+      fprintf(stderr, "short base snapshot\n");
+      return 2;
+    }
+  }
+  //records are hex byte pairs running up to END
+  log_in.head = log_in.tail = 0;
+  char pair[3] = {0};
+  while(fscanf(in, " %2s", pair) == 1 && strcmp(pair, "EN") != 0) {
+    if(log_in.tail == REPLAY_RING) {
+      fprintf(stderr, "log longer than the ring\n");
+      return 2;
+    }
+    log_in.bytes[log_in.tail++] = strtoul(pair, NULL, 16);
+  }
+  log_in.records = records;
+
+  double start = seconds();
+  replay_run(&log_in, &state, end_tick);
+  double elapsed = seconds() - start;
+
+  unsigned int got = core_hash(&state);
+  printf("seed:       %08x\n", seed);
+  printf("records:    %u in %u bytes\n", records, log_in.tail);
+  printf("ticks:      %u, %u pieces, %u lines\n", state.tick, state.pieces, state.lines);
+  printf("hash:       %08x, dump has %08x\n", got, hash);
+  printf("%.1f M ticks/s\n", state.tick / elapsed / 1e6);
+  if(got != hash || state.tick != end_tick) {
+    printf("DESYNC\n");
+    return 1;
+  }
+  printf("replay matches\n");
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  if(argc > 1 && strcmp(argv[1], "record") == 0) {
+    return record(argc > 2 ? strtoul(argv[2], NULL, 0) : 1, argc > 3 ? atoi(argv[3]) : 1000);
+  }
+  FILE* in = argc > 1 ? fopen(argv[1], "r") : stdin;
+  if(!in) {
+    perror(argv[1]);
+    return 2;
+  }
+  return play(in);
+}
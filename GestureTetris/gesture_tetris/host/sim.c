@@ -0,0 +1,101 @@
+// Host driver for the game core: plays seeded games with pseudo random input as
+// fast as the workstation allows and reports ticks per second plus a hash of the
+// final states, which must not change between runs with the same arguments.
+// Build with `make host`, run as ./host/sim [games] [ticks per game] [ai] [level],
+// where ai hands the games to the autoplayer instead of random input and level sets
+// the gravity the games are played at.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "core.h"
+#include "ai.h"
+#include "stats.h"
+
+static double seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+//one key press every few ticks, most of them moves
+static input_t next_input(unsigned int* rng) {
+  *rng = *rng * 1664525 + 1013904223;
+  unsigned int roll = *rng >> 24;
+  if(roll < 200) {
+    return INPUT_NONE;
+  }
+  return (input_t) (1 + roll % INPUT_ROTATE_180);
+}
+
+//one planned input per tick, planning again whenever a new piece spawns
+static input_t ai_input(const game_state_t* state, ai_plan_t* plan, int* next, unsigned int* planned) {
+  if(*planned != state->pieces + 1) {
+    *planned = state->pieces + 1;
+    *next = 0;
+    if(!ai_choose(state, plan)) {
+      plan->count = 0;
+    }
+  }
+  return *next < plan->count ? plan->moves[(*next)++] : INPUT_NONE;
+}
+
+int main(int argc, char* argv[]) {
+  int games = argc > 1 ? atoi(argv[1]) : 1000;
+  unsigned int ticks = argc > 2 ? atoi(argv[2]) : 100000;
+  int autoplay = argc > 3 && strcmp(argv[3], "ai") == 0;
+  int level = argc > 4 ? atoi(argv[4]) : MIN_LEVEL;
+
+  static game_state_t state;
+  unsigned long long total_ticks = 0, pieces = 0, lines = 0, score = 0;
+  int game_overs = 0;
+  unsigned int hash = 2166136261;
+  stats_t stats;
+  event_t e;
+
+  ai_init();
+  stats_init(&stats);
+  double start = seconds();
+  for(int game = 0; game < games; game++) {
+    unsigned int input_rng = game;
+    ai_plan_t plan;
+    int next = 0;
+    unsigned int planned = 0;
+    core_init(&state, game + 1);
+    core_set_level(&state, level);
+    while(!state.game_over && state.tick < ticks) {
+      if(autoplay) {
+        core_step(&state, ai_input(&state, &plan, &next, &planned));
+      } else {
+        core_step(&state, next_input(&input_rng));
+      }
+      //taken every tick like a frame would, so the queue never overflows
+      while(core_next_event(&state, &e)) {
+        stats_event(&stats, &e);
+      }
+    }
+    total_ticks += state.tick;
+    pieces += state.pieces;
+    lines += state.lines;
+    score += state.score;
+    game_overs += state.game_over;
+    hash = (hash ^ core_hash(&state)) * 16777619;
+  }
+  double elapsed = seconds() - start;
+
+  printf("games:      %d from level %d\n", games, level);
+  printf("ticks:      %llu\n", total_ticks);
+  printf("pieces:     %llu\n", pieces);
+  printf("lines:      %llu\n", lines);
+  printf("score:      %llu\n", score);
+  printf("game overs: %d\n", game_overs);
+  printf("hash:       %08x\n", hash);
+  stats_print(&stats);
+  if(autoplay) {
+    ai_stats_t ai = ai_get_stats();
+    printf("ai cache:   %u hits, %u misses (%.1f%% hit)\n", ai.hits, ai.misses,
+      100.0 * ai.hits / (ai.hits + ai.misses ? ai.hits + ai.misses : 1));
+  }
+  printf("%.1f M ticks/s, %.0f pieces/s\n", total_ticks / elapsed / 1e6, pieces / elapsed);
+  return 0;
+}
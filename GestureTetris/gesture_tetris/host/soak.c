@@ -0,0 +1,176 @@
+// Soak runner for the game core: plays thousands of seeded games across every core of
+// the workstation with the greedy autoplayer and reports pieces per second, lines,
+// top-outs and a hash of every game. Game n always plays seed n + 1, so the hashes
+// must not change with the thread count or between runs.
+// Build with `make soak`, run as ./host/soak [games] [threads] [pieces per game] [v],
+// where v prints the hash of each game as well as the combined one.
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "core.h"
+#include "ai.h"
+
+#define MAX_THREADS 64
+
+typedef struct {
+  unsigned int pieces;
+  unsigned int lines;
+  unsigned int ticks;
+  bool topped_out;
+  unsigned int hash;
+} result_t;
+
+//Games a worker still owns. The owner takes from the bottom, other workers steal
+//from the top, so a thief and the owner only meet on the last game.
+typedef struct {
+  pthread_mutex_t lock;
+  int top, bottom;
+} deque_t;
+
+typedef struct {
+  int id;
+  unsigned int steals;
+} worker_t;
+
+static deque_t deques[MAX_THREADS];
+static worker_t workers[MAX_THREADS];
+static int threads;
+static unsigned int max_pieces;
+static result_t* results;
+
+static double seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+//Plays game n to a top-out or max_pieces, one planned input per tick
+static void play(int n) {
+  game_state_t state;
+  ai_plan_t plan;
+  int next = 0;
+  core_init(&state, n + 1);
+  unsigned int planned = 0;
+  while(!state.game_over && state.pieces < max_pieces) {
+    if(planned != state.pieces + 1) {
+      planned = state.pieces + 1;
+      next = 0;
+      if(!ai_choose_greedy(&state, &plan)) {
+        plan.count = 0;
+      }
+    }
+    core_step(&state, next < plan.count ? plan.moves[next++] : INPUT_NONE);
+  }
+  result_t* r = &results[n];
+  r->pieces = state.pieces;
+  r->lines = state.lines;
+  r->ticks = state.tick;
+  r->topped_out = state.game_over;
+  r->hash = core_hash(&state);
+}
+
+static int take_own(deque_t* d) {
+  int n = -1;
+  pthread_mutex_lock(&d->lock);
+  if(d->top < d->bottom) {
+    n = --d->bottom;
+  }
+  pthread_mutex_unlock(&d->lock);
+  return n;
+}
+
+static int steal(deque_t* d) {
+  int n = -1;
+  pthread_mutex_lock(&d->lock);
+  if(d->top < d->bottom) {
+    n = d->top++;
+  }
+  pthread_mutex_unlock(&d->lock);
+  return n;
+}
+
+//Works through its own games, then steals from the others until every deque is empty
+static void* work(void* arg) {
+  worker_t* self = arg;
+  for(;;) {
+    int n = take_own(&deques[self->id]);
+    for(int i = 1; n < 0 && i < threads; i++) {
+      n = steal(&deques[(self->id + i) % threads]);
+      if(n >= 0) {
+        self->steals++;
+      }
+    }
+    if(n < 0) {
+      return NULL;
+    }
+    play(n);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  int games = argc > 1 ? atoi(argv[1]) : 4000;
+  threads = argc > 2 ? atoi(argv[2]) : 0;
+  max_pieces = argc > 3 ? atoi(argv[3]) : 2000;
+  int verbose = argc > 4 && strcmp(argv[4], "v") == 0;
+  if(threads <= 0) {
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if(threads > MAX_THREADS) {
+    threads = MAX_THREADS;
+  }
+  if(games < 1) {
+    games = 1;
+  }
+
+  results = calloc(games, sizeof(result_t));
+  //even split up front, stealing evens out games that run long
+  for(int i = 0; i < threads; i++) {
+    pthread_mutex_init(&deques[i].lock, NULL);
+    deques[i].top = (long long) games * i / threads;
+    deques[i].bottom = (long long) games * (i + 1) / threads;
+    workers[i].id = i;
+    workers[i].steals = 0;
+  }
+
+  pthread_t ids[MAX_THREADS];
+  double start = seconds();
+  for(int i = 0; i < threads; i++) {
+    pthread_create(&ids[i], NULL, work, &workers[i]);
+  }
+  unsigned int steals = 0;
+  for(int i = 0; i < threads; i++) {
+    pthread_join(ids[i], NULL);
+    steals += workers[i].steals;
+  }
+  double elapsed = seconds() - start;
+
+  //combined in game order so it does not depend on which thread played what
+  unsigned long long pieces = 0, lines = 0, ticks = 0;
+  int topped_out = 0;
+  unsigned int hash = 2166136261;
+  for(int n = 0; n < games; n++) {
+    result_t* r = &results[n];
+    pieces += r->pieces;
+    lines += r->lines;
+    ticks += r->ticks;
+    topped_out += r->topped_out;
+    hash = (hash ^ r->hash) * 16777619;
+    if(verbose) {
+      printf("game %5d seed %5d: %6u pieces %5u lines %s %08x\n", n, n + 1,
+        r->pieces, r->lines, r->topped_out ? "top-out " : "survived", r->hash);
+    }
+  }
+
+  printf("games:      %d on %d threads (%u steals)\n", games, threads, steals);
+  printf("ticks:      %llu\n", ticks);
+  printf("pieces:     %llu\n", pieces);
+  printf("lines:      %llu\n", lines);
+  printf("top-outs:   %d\n", topped_out);
+  printf("hash:       %08x\n", hash);
+  printf("%.0f pieces/s, %.1f s\n", pieces / elapsed, elapsed);
+  free(results);
+  return 0;
+}
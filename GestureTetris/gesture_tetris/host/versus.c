@@ -0,0 +1,242 @@
+// Host stand-in for a versus Pi: plays a match with the greedy autoplayer in real time
+// and speaks the link protocol over a serial device, paced to the 115200 baud of the
+// Pi's UART. Build with `make host`, then either
+//   ./host/versus pair [seconds] [delay ms]          two players on a pty pair made here
+//   ./host/versus /dev/ttyUSB0 [seconds] [delay ms]  one player against a Pi on that port
+// where delay holds every byte received that long before the link sees it. The match
+// stops at a game over or after seconds worth of ticks. Each player reports rollbacks,
+// what they cost, frames, bytes per second and the one-way latency measured from
+// heartbeat round trips, and a pair checks both sides ended on the same games.
+#define _XOPEN_SOURCE 700
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "core.h"
+#include "ai.h"
+#include "link.h"
+#include "versus.h"
+
+//115200 baud with a start and stop bit around each byte
+#define WIRE_BYTES_PER_SEC 11520
+#define TICK_US (1000000 / TICKS_PER_SECOND)
+//bytes that may go out back to back after an idle spell, the depth of the mini UART fifo
+#define WIRE_FIFO 8
+//bytes held back by the injected delay, a power of two
+#define DELAY_LINE 8192
+
+typedef struct {
+  const char* name;
+  int fd;
+  unsigned int seed;
+  int pace;                         //ticks between autoplayer presses
+  game_state_t local, remote;
+  link_t link;
+  versus_t versus;
+  ai_plan_t plan;
+  int next;
+  unsigned int planned;
+  unsigned long long wire_credit;   //bytes the wire could have carried, times 1e6
+  unsigned int last_us;
+  unsigned int end_us;
+  //bytes received and when the delay lets them through
+  unsigned char delayed[DELAY_LINE];
+  unsigned int due[DELAY_LINE];
+  unsigned int delay_head, delay_tail;
+  //time spent in updates that rolled back
+  unsigned int rollback_us, rollback_max_us;
+} player_t;
+
+static unsigned int run_seconds;
+static unsigned int delay_us;
+
+static unsigned int now_us(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000ull + now.tv_nsec / 1000;
+}
+
+static int open_raw(const char* path, int fd) {
+  if(fd < 0) {
+    fd = open(path, O_RDWR | O_NOCTTY);
+  }
+  if(fd < 0) {
+    perror(path);
+    exit(2);
+  }
+  struct termios tio;
+  if(tcgetattr(fd, &tio) == 0) {
+    tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+    tio.c_oflag &= ~OPOST;
+    tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(CSIZE | PARENB);
+    tio.c_cflag |= CS8 | CLOCAL | CREAD;
+    cfsetispeed(&tio, B115200);
+    cfsetospeed(&tio, B115200);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+//Moves bytes between the device and the link queues, no faster than the wire
+static void pump(player_t* p, unsigned int now) {
+  unsigned char buf[64];
+  ssize_t n;
+  while((n = read(p->fd, buf, sizeof(buf))) > 0) {
+    for(ssize_t i = 0; i < n && p->delay_tail - p->delay_head < DELAY_LINE; i++) {
+      p->delayed[p->delay_tail % DELAY_LINE] = buf[i];
+      p->due[p->delay_tail++ % DELAY_LINE] = now + delay_us;
+    }
+  }
+  while(p->delay_head != p->delay_tail && (int) (now - p->due[p->delay_head % DELAY_LINE]) >= 0) {
+    link_rx_put(&p->link, p->delayed[p->delay_head++ % DELAY_LINE]);
+  }
+  p->wire_credit += (unsigned long long) (now - p->last_us) * WIRE_BYTES_PER_SEC;
+  p->last_us = now;
+  if(p->wire_credit > WIRE_FIFO * 1000000ull) {
+    p->wire_credit = WIRE_FIFO * 1000000ull;
+  }
+  int count = 0;
+  while(p->wire_credit >= 1000000 && count < (int) sizeof(buf) && link_tx_get(&p->link, &buf[count])) {
+    p->wire_credit -= 1000000;
+    count++;
+  }
+  if(count) {
+    if(write(p->fd, buf, count) < 0) {
+      perror(p->name);
+    }
+  }
+}
+
+//Next move of the plan for the current piece, taken only once the match uses it
+static input_t autoplay(player_t* p) {
+  if(p->planned != p->local.pieces + 1) {
+    p->planned = p->local.pieces + 1;
+    p->next = 0;
+    if(!ai_choose_greedy(&p->local, &p->plan)) {
+      p->plan.count = 0;
+    }
+  }
+  return p->next < p->plan.count ? p->plan.moves[p->next] : INPUT_NONE;
+}
+
+static void update(player_t* p, unsigned int now) {
+  unsigned int rollbacks = p->versus.rollback.stats.rollbacks;
+  versus_update(&p->versus, now);
+  if(p->versus.rollback.stats.rollbacks != rollbacks) {
+    unsigned int took = now_us() - now;
+    p->rollback_us += took;
+    if(took > p->rollback_max_us) {
+      p->rollback_max_us = took;
+    }
+  }
+}
+
+//Plays until the match is over or has run its ticks, and every input is known to both sides
+static bool done(const player_t* p, unsigned int end_tick) {
+  const rollback_t* r = &p->versus.rollback;
+  bool settled = versus_over(&p->versus) || (r->tick == end_tick && r->confirmed >= end_tick);
+  return settled && versus_flushed(&p->versus);
+}
+
+static void* play(void* arg) {
+  player_t* p = arg;
+  unsigned int start = now_us();
+  unsigned int next_tick = start;
+  unsigned int end_tick = run_seconds * TICKS_PER_SECOND;
+  link_init(&p->link, NULL);
+  versus_init(&p->versus, &p->link, &p->local, &p->remote, p->seed, start);
+  p->last_us = start;
+  unsigned int now = start;
+  //a side that never hears from the other gives up
+  while(!done(p, end_tick) && now - start < (run_seconds * 2 + 5) * 1000000u) {
+    now = now_us();
+    if((int) (now - next_tick) >= 0) {
+      next_tick += TICK_US;
+      input_t input = p->versus.rollback.given % p->pace ? INPUT_NONE : autoplay(p);
+      if(p->versus.rollback.tick < end_tick && versus_tick(&p->versus, input) && input != INPUT_NONE) {
+        p->next++;
+      }
+    }
+    pump(p, now);
+    update(p, now);
+    pump(p, now);
+    //wake for the next tick, or sooner to keep the wire busy
+    int wait_ms = link_tx_empty(&p->link) ? (int) (next_tick - now) / 1000 : 1;
+    struct pollfd fds = {p->fd, POLLIN, 0};
+    poll(&fds, 1, wait_ms > 0 ? wait_ms : 0);
+  }
+  //let the last frames out, the other side may still need an ack
+  p->end_us = now_us();
+  while(now_us() - p->end_us < 200000) {
+    update(p, now_us());
+    pump(p, now_us());
+    poll(NULL, 0, 1);
+  }
+  return NULL;
+}
+
+static void report(player_t* p) {
+  printf("%s: seed %u, %u pieces, %u lines, score %u\n", p->name, p->seed,
+    p->local.pieces, p->local.lines, p->local.score);
+  versus_print(&p->versus, p->end_us);
+  const rollback_stats_t* s = &p->versus.rollback.stats;
+  if(s->rollbacks) {
+    printf("rollback us avg %u max %u\n", p->rollback_us / s->rollbacks, p->rollback_max_us);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  if(argc < 2) {
+    fprintf(stderr, "usage: %s pair|device [seconds]\n", argv[0]);
+    return 2;
+  }
+  run_seconds = argc > 2 ? atoi(argv[2]) : 30;
+  delay_us = argc > 3 ? atoi(argv[3]) * 1000 : 0;
+  static player_t players[2];
+  if(strcmp(argv[1], "pair") != 0) {
+    players[0] = (player_t) {.name = argv[1], .seed = now_us(), .pace = 1};
+    players[0].fd = open_raw(argv[1], -1);
+    play(&players[0]);
+    report(&players[0]);
+    return 0;
+  }
+
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if(master < 0 || grantpt(master) || unlockpt(master)) {
+    perror("pty");
+    return 2;
+  }
+  //the same pieces for both, so the slower one makes the games differ
+  players[0] = (player_t) {.name = "master", .seed = 1, .pace = 1};
+  players[1] = (player_t) {.name = ptsname(master), .seed = 2, .pace = 3};
+  players[0].fd = open_raw("pty master", master);
+  players[1].fd = open_raw(players[1].name, -1);
+  pthread_t ids[2];
+  for(int i = 0; i < 2; i++) {
+    pthread_create(&ids[i], NULL, play, &players[i]);
+  }
+  for(int i = 0; i < 2; i++) {
+    pthread_join(ids[i], NULL);
+  }
+  for(int i = 0; i < 2; i++) {
+    report(&players[i]);
+  }
+  //both sides simulated both games, so they must agree on each
+  const rollback_t* a = &players[0].versus.rollback;
+  const rollback_t* b = &players[1].versus.rollback;
+  bool same = a->tick == b->tick;
+  for(int g = 0; g < 2; g++) {
+    unsigned int ha = core_hash(a->games[g]), hb = core_hash(b->games[g]);
+    printf("player %d game: %08x %08x\n", g, ha, hb);
+    same = same && ha == hb;
+  }
+  printf("%s at tick %u\n", same ? "in sync" : "DESYNC", a->tick);
+  return same ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#ifndef AI_H
+#define AI_H
+#include "board.h"
+#include "core.h"
+#include <stdbool.h>
+
+//Autoplayer. Tries every placement of the current piece that can be reached by
+//rotating at the spawn, sliding and hard dropping, then every placement of the next
+//piece after it, and plans the inputs for the pair that leaves the best board.
+//Boards are cached by Zobrist hash, so ones reached more than one way are scored once.
+//Hardware free, so it runs on the host as well.
+
+//one rotation, up to WIDTH slides and the drop
+#define MAX_PLAN (WIDTH + 2)
+
+//entries in the score cache, a power of two
+#define AI_CACHE_SIZE 4096
+
+typedef struct {
+  input_t moves[MAX_PLAN];
+  int count;
+} ai_plan_t;
+
+typedef struct {
+  unsigned int hits;
+  unsigned int misses;
+} ai_stats_t;
+
+void ai_init(void);
+
+unsigned long long ai_hash(const board_t* board);
+
+ai_stats_t ai_get_stats(void);
+
+int ai_evaluate(const board_t* board, int lines);
+
+bool ai_choose(const game_state_t* state, ai_plan_t* plan);
+
+bool ai_choose_greedy(const game_state_t* state, ai_plan_t* plan);
+
+#endif
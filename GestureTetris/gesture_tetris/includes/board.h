@@ -0,0 +1,61 @@
+#ifndef BOARD_H
+#define BOARD_H
+#include "piece.h"
+#include <stdbool.h>
+
+#define WIDTH 10
+#define HEIGHT 20
+
+//Every row of the board is a single bitmask word. Column x of the board lives at
+//bit x + BOARD_PAD and every bit outside the playfield is set, so the walls and
+//the solid rows under the floor collide exactly like filled cells do.
+#define BOARD_PAD 3
+#define BOARD_FLOOR 4
+
+//a piece locked in these rows ends the game
+#define SPAWN_ROWS 2
+
+#define ROW_FULL 0xFFFFFFFF
+#define ROW_EMPTY (~(((1 << WIDTH) - 1) << BOARD_PAD))
+
+//cell id for a filled cell whose piece is not known, see snapshot_restore
+#define CELL_RESTORED (NUM_PIECES + 1)
+
+//cell id of garbage rows sent by the other player
+#define CELL_GARBAGE (NUM_PIECES + 2)
+
+typedef unsigned int row_t;
+
+typedef struct {
+  row_t rows[HEIGHT + BOARD_FLOOR];   //occupancy used for collision and line checks
+  char cells[HEIGHT][WIDTH];          //piece number + 1 of each cell for rendering, 0 if empty
+  unsigned char row_fill[HEIGHT];     //filled cells in each row
+  unsigned char col_height[WIDTH];    //stack height of each column, HEIGHT - y of its top cell
+  unsigned char height;               //tallest column
+} board_t;
+
+//inclusive range of rows, empty when top > bottom
+typedef struct {
+  int top;
+  int bottom;
+} row_range;
+
+void board_init(board_t* board);
+
+bool board_collides(const board_t* board, const piece_geometry* piece, int x, int y);
+
+bool board_is_line(const board_t* board, int y);
+
+unsigned int board_place(board_t* board, const piece_geometry* piece, int x, int y, char id);
+
+bool board_topped_out(const board_t* board);
+
+row_range board_clear_lines(board_t* board, unsigned int lines);
+
+int board_drop_distance(const board_t* board, const piece_geometry* piece, int x, int y);
+
+void board_refresh(board_t* board);
+
+bool board_add_garbage(board_t* board, int rows, int hole);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef CORE_H
+#define CORE_H
+#include "board.h"
+#include "piece.h"
+#include "randomizer.h"
+#include "events.h"
+#include <stdbool.h>
+
+//The rules of the game with no hardware underneath. The Pi drives the core from
+//game.c and the host build drives it from host/, both through core_step.
+
+#define TICKS_PER_SECOND 60
+
+//Gravity is rows per tick in 16.16 fixed point, so level 1 moves a fraction of a row
+//each tick and 20G lands the piece on the tick it spawns
+#define GRAVITY_ONE 65536
+#define MAX_GRAVITY (20 * GRAVITY_ONE)
+
+#define MIN_LEVEL 1
+#define MAX_LEVEL 20
+
+//points for each row a hard drop falls
+#define DROP_POINTS 2
+
+//ticks a piece rests on the stack before it locks, and how many moves or rotations
+//may restart that count before the piece falls to a new lowest row
+#define LOCK_TICKS 30
+#define MAX_LOCK_RESETS 15
+
+#define SPAWN_X 3
+#define SPAWN_Y 0
+
+typedef enum {
+  INPUT_NONE = 0,
+  INPUT_LEFT,
+  INPUT_RIGHT,
+  INPUT_ROTATE_CW,
+  INPUT_HARD_DROP,
+  INPUT_ROTATE_CCW,
+  INPUT_ROTATE_180,
+} input_t;
+
+typedef struct {
+  board_t board;
+  piece_state cur_piece;
+  randomizer_t randomizer;  //next pieces
+  unsigned int tick;
+  int level;
+  unsigned int gravity;     //rows per tick for the level, 16.16
+  unsigned int fall;        //fraction of a row fallen so far, 16.16
+  int lock_timer;           //ticks left on the stack before the piece locks
+  int lock_resets;          //lock timer restarts left
+  int lowest_y;             //lowest row the piece has reached
+  unsigned int pieces;      //pieces locked
+  unsigned int lines;       //lines cleared
+  unsigned int score;
+  unsigned int goal;        //lines total that starts the next level
+  unsigned char garbage;    //rows of garbage waiting for the next lock
+  unsigned char garbage_hole;
+  bool game_over;
+  event_queue_t events;     //changes not yet taken by core_next_event
+} game_state_t;
+
+void core_init(game_state_t* state, unsigned int seed);
+
+void core_step(game_state_t* state, input_t input);
+
+void core_set_level(game_state_t* state, int level);
+
+bool is_valid_state(const game_state_t* state, int new_x, int new_y, int new_rot);
+
+bool is_touching(const game_state_t* state);
+
+bool is_line(const game_state_t* state, int y);
+
+int landing_y(const game_state_t* state, piece_state piece);
+
+int next_piece(const game_state_t* state, int i);
+
+bool core_next_event(game_state_t* state, event_t* e);
+
+void core_queue_garbage(game_state_t* state, int rows, int hole);
+
+unsigned int core_hash(const game_state_t* state);
+
+#endif
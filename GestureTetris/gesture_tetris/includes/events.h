@@ -0,0 +1,45 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+#include <stdbool.h>
+
+//Change records the core emits as the game changes. The renderer and the stats
+//consumer apply them instead of comparing the board and piece against last frame.
+
+//records held at once, a power of two
+#define EVENT_QUEUE 64
+
+typedef enum {
+  EVENT_RESYNC = 0,   //records were lost or the game restarted, rebuild from the state
+  EVENT_SPAWNED,
+  EVENT_MOVED,
+  EVENT_ROTATED,
+  EVENT_LOCKED,
+  EVENT_CLEARED,
+  EVENT_SCORED,       //score, level or lines changed, the values are in the state
+  EVENT_GARBAGE,      //the other player's garbage pushed the stack up by lines rows
+  NUM_EVENTS,
+} event_type_t;
+
+//The piece fields hold the piece after the change, top and bottom the board rows a
+//lock or clear touched and lines how many rows a clear removed
+typedef struct {
+  unsigned char type;
+  unsigned char num, rot;
+  signed char x, y;
+  unsigned char top, bottom;
+  unsigned char lines;
+} event_t;
+
+typedef struct {
+  event_t events[EVENT_QUEUE];
+  unsigned int head, tail;
+  bool resync;            //a record was lost, EVENT_RESYNC is owed once the queue drains
+} event_queue_t;
+
+void events_init(event_queue_t* q);
+
+void events_push(event_queue_t* q, const event_t* e);
+
+bool events_pop(event_queue_t* q, event_t* e);
+
+#endif
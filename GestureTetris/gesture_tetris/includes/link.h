@@ -0,0 +1,63 @@
+#ifndef LINK_H
+#define LINK_H
+#include <stdbool.h>
+
+//Framed binary protocol over a serial byte stream. A frame is
+//  LINK_SYNC, type, sequence number, payload length, payload, CRC-16 (high byte first)
+//with the CRC-16/CCITT taken over everything after the sync byte. Bytes move through
+//two queues: an interrupt handler or the host transport fills rx and drains tx, and
+//the game only ever touches the queues, so it never waits on the wire.
+
+#define LINK_SYNC 0x7E
+#define LINK_MAX_PAYLOAD 16
+
+//bytes each queue holds, a power of two
+#define LINK_QUEUE 256
+
+//Single producer, single consumer. The producer writes the byte before it moves
+//tail and the consumer reads it before it moves head, so an interrupt on one side
+//needs no lock.
+typedef struct {
+  unsigned char bytes[LINK_QUEUE];
+  volatile unsigned int head, tail;
+} byte_queue_t;
+
+typedef struct {
+  unsigned char type;
+  unsigned char seq;
+  unsigned char len;
+  unsigned char payload[LINK_MAX_PAYLOAD];
+} link_frame_t;
+
+typedef struct {
+  unsigned int frames_sent, frames_received;
+  unsigned int bytes_sent, bytes_received;
+  unsigned int crc_errors;    //frames thrown away for a bad CRC or length
+  unsigned int lost;          //frames missing from the sequence numbers received
+  unsigned int dropped;       //frames not sent because tx was full
+} link_stats_t;
+
+typedef struct {
+  byte_queue_t rx, tx;
+  unsigned char seq;                    //sequence number of the next frame sent
+  unsigned char expect;                 //sequence number the next frame should have
+  bool synced;                          //a frame has come in, so expect means something
+  unsigned char frame[LINK_MAX_PAYLOAD + 5];    //frame being parsed, after the sync byte
+  int have;                             //bytes of it so far, -1 while hunting for sync
+  void (*kick)(void);                   //tells the transport tx has bytes, may be NULL
+  link_stats_t stats;
+} link_t;
+
+void link_init(link_t* link, void (*kick)(void));
+
+bool link_send(link_t* link, unsigned char type, const void* payload, int len);
+
+bool link_receive(link_t* link, link_frame_t* frame);
+
+bool link_rx_put(link_t* link, unsigned char byte);
+
+bool link_tx_get(link_t* link, unsigned char* byte);
+
+bool link_tx_empty(const link_t* link);
+
+#endif
@@ -1,13 +1,24 @@
 #ifndef PIECE_H
 #define PIECE_H
-#include "gl.h"
+
+#define NUM_PIECES 7
+
+//piece numbers
+enum { PIECE_I, PIECE_Z, PIECE_J, PIECE_L, PIECE_O, PIECE_S, PIECE_T };
 
 typedef char rot_state[4][4];
 
+//Geometry of one rotation, generated from the SRS macros below by tools/gen_pieces.c
 typedef struct {
-  color_t color;
-  rot_state states[4];
-} piece;
+  signed char cells[4][2];      //x, y of the 4 occupied cells within the 4x4 box
+  signed char left, right;      //bounding box, inclusive
+  signed char top, bottom;
+  signed char col_bottom[4];    //lowest occupied y of each column, -1 if empty
+  unsigned char rows[4];        //bit x of rows[y] is set if (x, y) is occupied
+} piece_geometry;
+
+//indexed by piece number then rotation, lives in piece_tables.c
+extern const piece_geometry piece_table[NUM_PIECES][4];
 
 typedef struct {
   int num;
@@ -0,0 +1,26 @@
+#ifndef RANDOMIZER_H
+#define RANDOMIZER_H
+#include "piece.h"
+
+//7-bag piece generator on a seeded xorshift PRNG. Every run of 7 pieces holds
+//each piece once, and the same seed always deals the same sequence.
+
+//pieces visible ahead of the current one, at most PREVIEW_RING, which is a power of two
+#define PREVIEW_DEPTH 5
+#define PREVIEW_RING 8
+
+typedef struct {
+  unsigned int rng;
+  unsigned char bag[NUM_PIECES];
+  unsigned char bag_left;                 //pieces not yet dealt from bag
+  unsigned char preview[PREVIEW_RING];    //ring of upcoming pieces
+  unsigned char head;                     //ring index of the next piece
+} randomizer_t;
+
+void randomizer_init(randomizer_t* r, unsigned int seed);
+
+int randomizer_next(randomizer_t* r);
+
+int randomizer_peek(const randomizer_t* r, int i);
+
+#endif
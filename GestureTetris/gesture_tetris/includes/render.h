@@ -3,14 +3,32 @@
 
 #include "piece.h"
 #include "gl.h"
-#include "game.h"
+#include "board.h"
+#include "events.h"
+
+//Boards the screen can be split between, side by side
+#define MAX_VIEWS 2
+
+typedef struct {
+  unsigned int presents;      //buffer swaps
+  unsigned int cells;         //board cells painted
+  unsigned long long pixels;  //framebuffer pixels written, panels included
+} render_stats_t;
 
 void render_init(void);
 
-void draw_board(void);
+void draw_score(int view, unsigned int score, int level, unsigned int lines);
+
+void render_event(int view, const event_t* e);
+
+void render_flush(void);
+
+void render_attach(int view, const board_t* board);
+
+void render_uart_dump(bool on);
 
-void draw_piece(piece_state piece);
+render_stats_t render_get_stats(void);
 
-void graphics_init(void);
+void graphics_init(int boards);
 
 #endif
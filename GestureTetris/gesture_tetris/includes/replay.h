@@ -0,0 +1,32 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+#include "core.h"
+#include "snapshot.h"
+
+//Input log for reproducing a game. Each input the core applies is one varint of the
+//ticks since the last one shifted over the 3-bit input code, a byte or two an input,
+//kept in a RAM ring after the state the oldest record applies to.
+
+//bytes of records kept, a power of two
+#define REPLAY_RING 4096
+
+typedef struct {
+  unsigned int seed;                    //seed the game was started with, for reference
+  snapshot_t base;                      //state the oldest record starts from
+  unsigned char bytes[REPLAY_RING];     //ring of encoded records
+  unsigned int head, tail;
+  unsigned int next_tick;               //tick the next record counts its gap from
+  unsigned int records;
+} replay_log_t;
+
+void replay_init(replay_log_t* log, const game_state_t* state, unsigned int seed);
+
+void replay_record(replay_log_t* log, const game_state_t* state, input_t input);
+
+bool replay_next(const replay_log_t* log, unsigned int* pos, unsigned int* tick, input_t* input);
+
+void replay_run(const replay_log_t* log, game_state_t* state, unsigned int end_tick);
+
+void replay_dump(const replay_log_t* log, const game_state_t* state);
+
+#endif
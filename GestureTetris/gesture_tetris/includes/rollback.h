@@ -0,0 +1,55 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+#include "core.h"
+#include "snapshot.h"
+
+//Lockstep play of a versus match. Each side simulates both games from both players'
+//inputs, so garbage and game over come out the same on both sides without being
+//sent. The other player's inputs arrive late, so the match runs ahead guessing that
+//they pressed nothing, keeps a snapshot of each game before every tick, and when an
+//input turns out to be something else it restores that game to the tick and
+//simulates it forward again.
+
+//ticks the match may run ahead of the last remote input it has, then it waits
+#define ROLLBACK_WINDOW 12
+
+//ticks of snapshots and inputs kept, a power of two
+#define ROLLBACK_RING 32
+
+typedef struct {
+  unsigned int rollbacks;     //late inputs that changed a guess
+  unsigned int resimulated;   //game ticks simulated again
+  unsigned int deepest;       //most ticks rolled back at once
+  unsigned int stalls;        //ticks waited out for remote inputs or acks
+} rollback_stats_t;
+
+typedef struct {
+  game_state_t* games[2];     //by player, games[local] is this side's
+  int local;
+  unsigned int tick;          //ticks the match has simulated
+  unsigned int confirmed;     //remote inputs are known for every tick before this
+  unsigned int given;         //local inputs are fixed for every tick before this
+  unsigned int acked;         //the other side has every local input before this
+  //each game before tick t, the input each player gave at t (guessed for the remote
+  //player from confirmed on) and the garbage each game sent at t as rows | hole << 4,
+  //all at t % ROLLBACK_RING
+  snapshot_t snaps[ROLLBACK_RING][2];
+  //the cell ids of each snapshot's board, which the snapshot leaves out, so a rolled
+  //back game keeps its pieces' colors
+  char cells[ROLLBACK_RING][2][HEIGHT][WIDTH];
+  unsigned char inputs[ROLLBACK_RING][2];
+  unsigned char garbage[ROLLBACK_RING][2];
+  rollback_stats_t stats;
+} rollback_t;
+
+void rollback_init(rollback_t* r, game_state_t* local_game, game_state_t* remote_game, int local, unsigned int seed);
+
+bool rollback_tick(rollback_t* r, input_t input);
+
+void rollback_receive(rollback_t* r, unsigned int start, const unsigned char* inputs, int count);
+
+input_t rollback_local_input(const rollback_t* r, unsigned int tick);
+
+bool rollback_over(const rollback_t* r);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef ROTATION_H
+#define ROTATION_H
+#include "board.h"
+#include "piece.h"
+#include <stdbool.h>
+
+//quarter turns clockwise
+#define TURN_CW 1
+#define TURN_180 2
+#define TURN_CCW 3
+
+//most kick offsets any rotation tries, including the unkicked one
+#define MAX_KICKS 6
+
+bool rotate_piece(const board_t* board, piece_state* piece, int turns);
+
+#endif
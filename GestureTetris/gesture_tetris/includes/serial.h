@@ -0,0 +1,14 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+#include "link.h"
+
+//Interrupt driven mini UART under a link. Received bytes go into the link's rx queue
+//from the interrupt and its tx queue drains into the UART whenever the FIFO has room,
+//so nothing in the game loop waits on the wire. Nothing else may print to the UART
+//while a link is attached.
+
+void serial_init(link_t* link);
+
+void serial_kick(void);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include "core.h"
+
+//Everything core_step reads, packed into a fixed blob: each board row as a 10-bit
+//mask, then the piece, randomizer, gravity and lock timers and counters as bit
+//fields. Saving and restoring copy a few words, so rewinding or cloning a game for
+//search is cheap. Cell colors are not kept, see snapshot_restore.
+
+//bits used, as laid out in snapshot.c
+#define SNAPSHOT_BITS (HEIGHT * WIDTH + 15 + 32 + 24 + 3 * PREVIEW_DEPTH + 32 + 5 + 16 + 5 + 4 + 5 + 32 + 32 + 32 + 32 + 5 + 4 + 1)
+#define SNAPSHOT_WORDS ((SNAPSHOT_BITS + 31) / 32)
+
+typedef struct {
+  unsigned int words[SNAPSHOT_WORDS];
+} snapshot_t;
+
+void snapshot_save(const game_state_t* state, snapshot_t* snap);
+
+void snapshot_restore(game_state_t* state, const snapshot_t* snap);
+
+#endif
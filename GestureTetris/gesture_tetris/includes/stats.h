@@ -0,0 +1,22 @@
+#ifndef STATS_H
+#define STATS_H
+#include "events.h"
+
+//Counts what happened in a game from the core's change records, no polling
+
+//clears of one to four rows
+#define MAX_CLEAR 4
+
+typedef struct {
+  unsigned int counts[NUM_EVENTS];        //records seen of each type
+  unsigned int clears[MAX_CLEAR + 1];     //clears by the number of rows they removed
+  unsigned int lines;
+} stats_t;
+
+void stats_init(stats_t* stats);
+
+void stats_event(stats_t* stats, const event_t* e);
+
+void stats_print(const stats_t* stats);
+
+#endif
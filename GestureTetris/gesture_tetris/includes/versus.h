@@ -0,0 +1,66 @@
+#ifndef VERSUS_H
+#define VERSUS_H
+#include "core.h"
+#include "link.h"
+#include "rollback.h"
+
+//Head to head play over a link. Both sides say hello with a seed, the lower seed
+//becomes player 0 and its seed starts both games. From then on each side sends its
+//inputs, acking the other side's, and runs the match in lockstep with rollback. A
+//heartbeat the other side echoes straight back times the round trip.
+
+//ticks between heartbeats
+#define HEARTBEAT_TICKS 30
+
+//microseconds before a hello or inputs that were not acked go out again
+#define RESEND_US 50000
+
+//a side further ahead than the other gives up a tick at most this often to even out
+#define SYNC_TICKS 8
+
+//inputs a frame carries, two to a byte after a 10 byte header
+#define INPUTS_PER_FRAME (2 * (LINK_MAX_PAYLOAD - 10))
+
+enum {
+  MSG_HEARTBEAT = 1,
+  MSG_ECHO,
+  MSG_HELLO,
+  MSG_INPUTS,
+};
+
+typedef struct {
+  link_t* link;
+  rollback_t rollback;
+  game_state_t* local_game;
+  game_state_t* remote_game;
+  bool started;                     //hellos were traded and the match is running
+  bool heard;                       //inputs have come in, so the hello got through
+  unsigned int own_seed;            //the one our hello carries, before and after the start
+  unsigned int seed;                //the match's once it starts
+  unsigned int sent;                //local inputs before this tick have gone out once
+  unsigned int ack_sent;            //last ack the other side was sent
+  unsigned int last_send_us;
+  int remote_lead;                  //ticks the other side was ahead of what it had from us
+  unsigned int waits;               //ticks given up so the other side could catch up
+  unsigned int next_wait;           //tick the next one may be given up on
+  unsigned int next_heartbeat;      //tick the next heartbeat is due
+  unsigned int start_us;
+  //one-way latency in microseconds, half of each heartbeat round trip
+  unsigned int latency_samples, latency_min, latency_max;
+  unsigned long long latency_total;
+} versus_t;
+
+void versus_init(versus_t* v, link_t* link, game_state_t* local_game, game_state_t* remote_game,
+  unsigned int seed, unsigned int now_us);
+
+bool versus_tick(versus_t* v, input_t input);
+
+void versus_update(versus_t* v, unsigned int now_us);
+
+bool versus_over(const versus_t* v);
+
+bool versus_flushed(const versus_t* v);
+
+void versus_print(const versus_t* v, unsigned int now_us);
+
+#endif
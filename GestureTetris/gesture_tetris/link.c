@@ -0,0 +1,134 @@
+#include "link.h"
+
+//CRC-16/CCITT a nibble at a time, a 16 entry table instead of 256
+static const unsigned short crc_nibble[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+static unsigned short crc16(const unsigned char* bytes, int len) {
+  unsigned short crc = 0xFFFF;
+  for(int i = 0; i < len; i++) {
+    crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (bytes[i] >> 4)];
+    crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (bytes[i] & 0xF)];
+  }
+  return crc;
+}
+
+static bool queue_put(byte_queue_t* q, unsigned char byte) {
+  if(q->tail - q->head == LINK_QUEUE) {
+    return false;
+  }
+  q->bytes[q->tail % LINK_QUEUE] = byte;
+  q->tail++;
+  return true;
+}
+
+static bool queue_get(byte_queue_t* q, unsigned char* byte) {
+  if(q->head == q->tail) {
+    return false;
+  }
+  *byte = q->bytes[q->head % LINK_QUEUE];
+  q->head++;
+  return true;
+}
+
+void link_init(link_t* link, void (*kick)(void)) {
+  link->rx.head = link->rx.tail = 0;
+  link->tx.head = link->tx.tail = 0;
+  link->seq = 0;
+  link->expect = 0;
+  link->synced = false;
+  link->have = -1;
+  link->kick = kick;
+  link_stats_t zero = {0};
+  link->stats = zero;
+}
+
+//Queues a whole frame or nothing. Returns false and drops the frame when tx has no
+//room for it, the caller decides whether it matters.
+bool link_send(link_t* link, unsigned char type, const void* payload, int len) {
+  if(len > LINK_MAX_PAYLOAD || LINK_QUEUE - (link->tx.tail - link->tx.head) < (unsigned int) len + 6) {
+    link->stats.dropped++;
+    return false;
+  }
+  unsigned char frame[LINK_MAX_PAYLOAD + 6];
+  frame[0] = LINK_SYNC;
+  frame[1] = type;
+  frame[2] = link->seq++;
+  frame[3] = len;
+  for(int i = 0; i < len; i++) {
+    frame[4 + i] = ((const unsigned char*) payload)[i];
+  }
+  unsigned short crc = crc16(frame + 1, len + 3);
+  frame[4 + len] = crc >> 8;
+  frame[5 + len] = crc & 0xFF;
+  for(int i = 0; i < len + 6; i++) {
+    queue_put(&link->tx, frame[i]);
+  }
+  link->stats.frames_sent++;
+  link->stats.bytes_sent += len + 6;
+  if(link->kick) {
+    link->kick();
+  }
+  return true;
+}
+
+//Parses the bytes received so far and returns the next good frame. A bad CRC or
+//length drops back to hunting for the next sync byte.
+bool link_receive(link_t* link, link_frame_t* frame) {
+  unsigned char byte;
+  while(queue_get(&link->rx, &byte)) {
+    link->stats.bytes_received++;
+    if(link->have < 0) {
+      if(byte == LINK_SYNC) {
+        link->have = 0;
+      }
+      continue;
+    }
+    link->frame[link->have++] = byte;
+    if(link->have == 3 && link->frame[2] > LINK_MAX_PAYLOAD) {
+      link->stats.crc_errors++;
+      link->have = byte == LINK_SYNC ? 0 : -1;
+      continue;
+    }
+    if(link->have < 3 || link->have < link->frame[2] + 5) {
+      continue;
+    }
+    int len = link->frame[2];
+    link->have = -1;
+    unsigned short crc = link->frame[3 + len] << 8 | link->frame[4 + len];
+    if(crc != crc16(link->frame, len + 3)) {
+      link->stats.crc_errors++;
+      continue;
+    }
+    frame->type = link->frame[0];
+    frame->seq = link->frame[1];
+    frame->len = len;
+    for(int i = 0; i < len; i++) {
+      frame->payload[i] = link->frame[3 + i];
+    }
+    if(link->synced) {
+      link->stats.lost += (unsigned char) (frame->seq - link->expect);
+    }
+    link->synced = true;
+    link->expect = frame->seq + 1;
+    link->stats.frames_received++;
+    return true;
+  }
+  return false;
+}
+
+//Transport side: a byte off the wire. Returns false if rx was full and it was lost.
+bool link_rx_put(link_t* link, unsigned char byte) {
+  return queue_put(&link->rx, byte);
+}
+
+//Transport side: the next byte to put on the wire
+bool link_tx_get(link_t* link, unsigned char* byte) {
+  return queue_get(&link->tx, byte);
+}
+
+bool link_tx_empty(const link_t* link) {
+  return link->tx.head == link->tx.tail;
+}
@@ -22,7 +22,5 @@ void main(void)
   interrupts_global_enable(); // everything fully initialized, now turn on interrupts
   printf("hit\n");
 
-  while(true){
-    handle_input(keyboard_read_next());
-  }
+  game_run();
 }
@@ -0,0 +1,47 @@
+// Generated by tools/gen_pieces.c from the SRS macros in piece.h, do not edit.
+#include "piece.h"
+
+const piece_geometry piece_table[NUM_PIECES][4] = {
+  { //I
+    {{{0, 1}, {1, 1}, {2, 1}, {3, 1}}, 0, 3, 1, 1, {1, 1, 1, 1}, {0x0, 0xf, 0x0, 0x0}},
+    {{{2, 0}, {2, 1}, {2, 2}, {2, 3}}, 2, 2, 0, 3, {-1, -1, 3, -1}, {0x4, 0x4, 0x4, 0x4}},
+    {{{0, 2}, {1, 2}, {2, 2}, {3, 2}}, 0, 3, 2, 2, {2, 2, 2, 2}, {0x0, 0x0, 0xf, 0x0}},
+    {{{1, 0}, {1, 1}, {1, 2}, {1, 3}}, 1, 1, 0, 3, {-1, 3, -1, -1}, {0x2, 0x2, 0x2, 0x2}},
+  },
+  { //Z
+    {{{0, 0}, {1, 0}, {1, 1}, {2, 1}}, 0, 2, 0, 1, {0, 1, 1, -1}, {0x3, 0x6, 0x0, 0x0}},
+    {{{2, 0}, {1, 1}, {2, 1}, {1, 2}}, 1, 2, 0, 2, {-1, 2, 1, -1}, {0x4, 0x6, 0x2, 0x0}},
+    {{{0, 1}, {1, 1}, {1, 2}, {2, 2}}, 0, 2, 1, 2, {1, 2, 2, -1}, {0x0, 0x3, 0x6, 0x0}},
+    {{{1, 0}, {0, 1}, {1, 1}, {0, 2}}, 0, 1, 0, 2, {2, 1, -1, -1}, {0x2, 0x3, 0x1, 0x0}},
+  },
+  { //J
+    {{{0, 0}, {0, 1}, {1, 1}, {2, 1}}, 0, 2, 0, 1, {1, 1, 1, -1}, {0x1, 0x7, 0x0, 0x0}},
+    {{{1, 0}, {2, 0}, {1, 1}, {1, 2}}, 1, 2, 0, 2, {-1, 2, 0, -1}, {0x6, 0x2, 0x2, 0x0}},
+    {{{0, 1}, {1, 1}, {2, 1}, {2, 2}}, 0, 2, 1, 2, {1, 1, 2, -1}, {0x0, 0x7, 0x4, 0x0}},
+    {{{1, 0}, {1, 1}, {0, 2}, {1, 2}}, 0, 1, 0, 2, {2, 2, -1, -1}, {0x2, 0x2, 0x3, 0x0}},
+  },
+  { //L
+    {{{2, 0}, {0, 1}, {1, 1}, {2, 1}}, 0, 2, 0, 1, {1, 1, 1, -1}, {0x4, 0x7, 0x0, 0x0}},
+    {{{1, 0}, {1, 1}, {1, 2}, {2, 2}}, 1, 2, 0, 2, {-1, 2, 2, -1}, {0x2, 0x2, 0x6, 0x0}},
+    {{{0, 1}, {1, 1}, {2, 1}, {0, 2}}, 0, 2, 1, 2, {2, 1, 1, -1}, {0x0, 0x7, 0x1, 0x0}},
+    {{{0, 0}, {1, 0}, {1, 1}, {1, 2}}, 0, 1, 0, 2, {0, 2, -1, -1}, {0x3, 0x2, 0x2, 0x0}},
+  },
+  { //O
+    {{{1, 0}, {2, 0}, {1, 1}, {2, 1}}, 1, 2, 0, 1, {-1, 1, 1, -1}, {0x6, 0x6, 0x0, 0x0}},
+    {{{1, 0}, {2, 0}, {1, 1}, {2, 1}}, 1, 2, 0, 1, {-1, 1, 1, -1}, {0x6, 0x6, 0x0, 0x0}},
+    {{{1, 0}, {2, 0}, {1, 1}, {2, 1}}, 1, 2, 0, 1, {-1, 1, 1, -1}, {0x6, 0x6, 0x0, 0x0}},
+    {{{1, 0}, {2, 0}, {1, 1}, {2, 1}}, 1, 2, 0, 1, {-1, 1, 1, -1}, {0x6, 0x6, 0x0, 0x0}},
+  },
+  { //S
+    {{{1, 0}, {2, 0}, {0, 1}, {1, 1}}, 0, 2, 0, 1, {1, 1, 0, -1}, {0x6, 0x3, 0x0, 0x0}},
+    {{{1, 0}, {1, 1}, {2, 1}, {2, 2}}, 1, 2, 0, 2, {-1, 1, 2, -1}, {0x2, 0x6, 0x4, 0x0}},
+    {{{1, 1}, {2, 1}, {0, 2}, {1, 2}}, 0, 2, 1, 2, {2, 2, 1, -1}, {0x0, 0x6, 0x3, 0x0}},
+    {{{0, 0}, {0, 1}, {1, 1}, {1, 2}}, 0, 1, 0, 2, {1, 2, -1, -1}, {0x1, 0x3, 0x2, 0x0}},
+  },
+  { //T
+    {{{1, 0}, {0, 1}, {1, 1}, {2, 1}}, 0, 2, 0, 1, {1, 1, 1, -1}, {0x2, 0x7, 0x0, 0x0}},
+    {{{1, 0}, {1, 1}, {2, 1}, {1, 2}}, 1, 2, 0, 2, {-1, 2, 1, -1}, {0x2, 0x6, 0x2, 0x0}},
+    {{{0, 1}, {1, 1}, {2, 1}, {1, 2}}, 0, 2, 1, 2, {1, 2, 1, -1}, {0x0, 0x7, 0x2, 0x0}},
+    {{{1, 0}, {0, 1}, {1, 1}, {1, 2}}, 0, 1, 0, 2, {1, 2, -1, -1}, {0x2, 0x3, 0x2, 0x0}},
+  },
+};
@@ -0,0 +1,61 @@
+#include "randomizer.h"
+
+//any nonzero state works, zero would stay zero forever
+#define DEFAULT_SEED 0x2545F491
+
+static unsigned int xorshift(randomizer_t* r) {
+  unsigned int x = r->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  r->rng = x;
+  return x;
+}
+
+//Uniform in [0, n) from a multiply and shift, there is no divide instruction to spare
+static int random_below(randomizer_t* r, int n) {
+  return ((unsigned long long) xorshift(r) * n) >> 32;
+}
+
+//Fisher-Yates shuffle of a fresh bag
+static void refill_bag(randomizer_t* r) {
+  for(int i = 0; i < NUM_PIECES; i++) {
+    r->bag[i] = i;
+  }
+  for(int i = NUM_PIECES - 1; i > 0; i--) {
+    int j = random_below(r, i + 1);
+    unsigned char swap = r->bag[i];
+    r->bag[i] = r->bag[j];
+    r->bag[j] = swap;
+  }
+  r->bag_left = NUM_PIECES;
+}
+
+static int deal(randomizer_t* r) {
+  if(!r->bag_left) {
+    refill_bag(r);
+  }
+  return r->bag[--r->bag_left];
+}
+
+void randomizer_init(randomizer_t* r, unsigned int seed) {
+  r->rng = seed ? seed : DEFAULT_SEED;
+  r->bag_left = 0;
+  r->head = 0;
+  for(int i = 0; i < PREVIEW_DEPTH; i++) {
+    r->preview[i] = deal(r);
+  }
+}
+
+//Takes the next piece off the preview and deals a new one onto the end of it
+int randomizer_next(randomizer_t* r) {
+  int piece = r->preview[r->head];
+  r->preview[(r->head + PREVIEW_DEPTH) & (PREVIEW_RING - 1)] = deal(r);
+  r->head = (r->head + 1) & (PREVIEW_RING - 1);
+  return piece;
+}
+
+//Piece i places ahead in the preview, 0 is the one that spawns next
+int randomizer_peek(const randomizer_t* r, int i) {
+  return r->preview[(r->head + i) & (PREVIEW_RING - 1)];
+}
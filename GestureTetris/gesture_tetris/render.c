@@ -1,15 +1,92 @@
 #include "render.h"
 #include "gl.h"
+#include "glextra.h"
 #include "printf.h"
-#include "game.h"
+#include "board.h"
+#include "events.h"
 
-piece_state prev_piece;
+//pixels per cell side when a board has the room, and the widest the boards and their
+//panels may be together before the cells shrink to fit
+#define CELL_SIZE 50
+#define MAX_SCREEN_WIDTH 1600
 
-void draw_board(void) {
+//score panel to the right of each board
+#define PANEL_WIDTH 160
+
+//damage rectangles each buffer keeps before they are merged into fewer, larger ones
+#define MAX_DAMAGE 32
+
+//What a cell on screen shows: 0 for empty, a board cell's value, or GHOST + piece
+//number for a ghost cell. The falling piece shows as the cell it will lock as.
+#define GHOST 16
+
+typedef struct {
+  int x, y, w, h;
+} rect_t;
+
+//Screen areas a buffer shows out of date, changed since it was last the back buffer
+typedef struct {
+  rect_t rects[MAX_DAMAGE];
+  int count;
+} damage_t;
+
+//One board on screen: where it is and what it last drew
+typedef struct {
+  const board_t* board;
+  int x, y;                   //top left corner of the board
+  int cell;                   //pixels per cell side
+  piece_state piece;          //falling piece as of the last record
+  bool piece_shown;           //it has not locked since, a game that ends on a lock has none
+  bool board_changed;         //a record changed the board since the last flush
+  bool changed;               //any record came in since the last flush
+  unsigned char shadow[HEIGHT][WIDTH];   //cells as last drawn into either buffer
+  //values the panel shows, drawn once into a surface that each buffer gets a copy of
+  unsigned int panel_score, panel_lines;
+  int panel_level;
+  gl_surface_t* panel;
+} view_t;
+
+static view_t views[MAX_VIEWS];
+static int view_count;
+static render_stats_t stats;
+
+//what each half of the framebuffer is owed, and which half is the back buffer
+static damage_t damage[2];
+static int back;
+
+//board printed to the UART on every change to it, off while the UART carries a link
+static bool uart_dump = true;
+
+//indexed by piece number, I Z J L O S T, then cells restored from a snapshot and garbage
+static const color_t piece_colors[NUM_PIECES + 2] = {
+  0xFF00FF00, 0xFF00FF00, 0xFFFF0000, 0xFF0000AA, 0xFF00FFFF, 0xFF00FF00, 0xFFFF00FF,
+  0xFF808080, 0xFF505050
+};
+
+//Color of each cell value, ghost cells being the piece color at a quarter of its
+//brightness, worked out once for every board
+static color_t cell_colors[GHOST + NUM_PIECES];
+
+//Bevelled cell graphics for the piece colors side by side, cell value 1 leftmost,
+//drawn once at the cell size of the boards and copied in row by row. Empty and ghost
+//cells are flat and still filled, as is everything if there was no memory for them.
+static gl_surface_t* tiles;
+
+static void draw_cell(const view_t* v, int x, int y, unsigned char cell) {
+  if(tiles && cell >= 1 && cell <= NUM_PIECES + 2) {
+    gl_blit(NULL, v->x + x * v->cell, v->y + y * v->cell, tiles, (cell - 1) * v->cell, 0, v->cell, v->cell);
+  } else {
+    gl_draw_rect(v->x + x * v->cell, v->y + y * v->cell, v->cell, v->cell, cell_colors[cell]);
+  }
+  stats.cells++;
+  stats.pixels += v->cell * v->cell;
+}
+
+static void dump_board(const board_t* board) {
   for(int y = 0; y < 20; y++) {
     printf("|");
     for(int x = 0; x < 10; x++) {
-      if(board[y][x]) {
+      if(board->cells[y][x]) {
         printf("O");
       } else {
         printf(" ");
@@ -18,42 +95,320 @@ void draw_board(void) {
     printf("|\n");
   }
   printf(" ----------\n");
+}
 
-  for(int y = 0; y < 20; y++) {
-    for(int x = 0; x < 10; x++) {
-      if(board[y][x]) {
-        gl_draw_rect(x * 50, y * 50, 50,  50, piece_map[(int) board[y][x] - 1]->color);
+static int area(rect_t r) {
+  return r.w * r.h;
+}
+
+static rect_t bounds(rect_t a, rect_t b) {
+  int x0 = a.x < b.x ? a.x : b.x, y0 = a.y < b.y ? a.y : b.y;
+  int x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+  int y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+  return (rect_t) {x0, y0, x1 - x0, y1 - y0};
+}
+
+static bool overlaps(rect_t a, rect_t b) {
+  return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+//Adds r to a buffer's damage. A rectangle that holds r, or that r fits against with
+//nothing left over, takes it in. With the list full it goes to the rectangle it adds
+//the least area to, since repainting more than changed never shows anything wrong.
+static void damage_add(damage_t* d, rect_t r) {
+  int best = 0, best_waste = 0;
+  for(int i = 0; i < d->count; i++) {
+    rect_t u = bounds(d->rects[i], r);
+    int waste = area(u) - area(d->rects[i]) - area(r);
+    if(area(u) == area(d->rects[i]) || (waste == 0 && !overlaps(d->rects[i], r))) {
+      d->rects[i] = u;
+      return;
+    }
+    if(i == 0 || waste < best_waste) {
+      best = i;
+      best_waste = waste;
+    }
+  }
+  if(d->count < MAX_DAMAGE) {
+    d->rects[d->count++] = r;
+  } else {
+    d->rects[best] = bounds(d->rects[best], r);
+  }
+}
+
+//Both buffers show r out of date until each has been drawn once more
+static void damage_both(rect_t r) {
+  damage_add(&damage[0], r);
+  damage_add(&damage[1], r);
+}
+
+static rect_t panel_rect(const view_t* v) {
+  return (rect_t) {v->x + WIDTH * v->cell, v->y, PANEL_WIDTH, 7 * (gl_get_char_height() + 4)};
+}
+
+//Puts the cells the board should show now in want: the board, the ghost and the piece
+static void compose(const view_t* v, unsigned char want[HEIGHT][WIDTH]) {
+  const board_t* board = v->board;
+  for(int y = 0; y < HEIGHT; y++) {
+    for(int x = 0; x < WIDTH; x++) {
+      want[y][x] = board->cells[y][x];
+    }
+  }
+  if(!v->piece_shown) {
+    return;
+  }
+  piece_state piece = v->piece;
+  const piece_geometry* geom = &piece_table[piece.num][piece.rot];
+  int ghost_y = piece.y + board_drop_distance(board, geom, piece.x, piece.y);
+  for(int i = 0; i < 4; i++) {
+    want[ghost_y + geom->cells[i][1]][piece.x + geom->cells[i][0]] = GHOST + piece.num;
+  }
+  for(int i = 0; i < 4; i++) {
+    want[piece.y + geom->cells[i][1]][piece.x + geom->cells[i][0]] = piece.num + 1;
+  }
+}
+
+//Brings the shadow up to date and damages the cells that changed, cells that became
+//empty included, each run of them along a row as one rectangle
+static void update_board(view_t* v) {
+  unsigned char want[HEIGHT][WIDTH];
+  compose(v, want);
+  for(int y = 0; y < HEIGHT; y++) {
+    for(int x = 0; x < WIDTH; x++) {
+      int run = x;
+      while(run < WIDTH && want[y][run] != v->shadow[y][run]) {
+        v->shadow[y][run] = want[y][run];
+        run++;
+      }
+      if(run > x) {
+        damage_both((rect_t) {v->x + x * v->cell, v->y + y * v->cell, (run - x) * v->cell, v->cell});
+        x = run;
       }
     }
   }
-  gl_swap_buffer();
 }
 
-void draw_piece(piece_state piece) {
-  for(int piece_x = 0; piece_x < 4; piece_x++) {
-    for(int piece_y = 0; piece_y < 4; piece_y++) {
-      if(piece_map[piece.num]->states[piece.rot][piece_y][piece_x]) {
-        gl_draw_rect((piece.x + piece_x) * 50, (piece.y + piece_y) * 50, 50,  50, piece_map[piece.num]->color);
+//Repaints the board cells r touches from the shadow, each cell once a flush
+static void repaint_cells(const view_t* v, rect_t r, unsigned short painted[HEIGHT]) {
+  rect_t board = {v->x, v->y, WIDTH * v->cell, HEIGHT * v->cell};
+  if(!overlaps(board, r)) {
+    return;
+  }
+  int left = r.x > board.x ? (r.x - board.x) / v->cell : 0;
+  int top = r.y > board.y ? (r.y - board.y) / v->cell : 0;
+  int right = (r.x + r.w - board.x - 1) / v->cell;
+  int bottom = (r.y + r.h - board.y - 1) / v->cell;
+  right = right < WIDTH - 1 ? right : WIDTH - 1;
+  bottom = bottom < HEIGHT - 1 ? bottom : HEIGHT - 1;
+  for(int y = top; y <= bottom; y++) {
+    for(int x = left; x <= right; x++) {
+      if(!(painted[y] & (1 << x))) {
+        painted[y] |= 1 << x;
+        draw_cell(v, x, y, v->shadow[y][x]);
       }
     }
   }
-  gl_swap_buffer();
-  //clear previous piece in draw buffer
-  for(int piece_x = 0; piece_x < 4; piece_x++) {
-    for(int piece_y = 0; piece_y < 4; piece_y++) {
-      if(piece_map[prev_piece.num]->states[prev_piece.rot][piece_y][piece_x]) {
-        gl_draw_rect((prev_piece.x + piece_x) * 50, (prev_piece.y + piece_y) * 50, 50,  50, GL_BLACK);
+}
+
+//Draws the panel's text into its surface, the buffers get it as they are repainted
+static void compose_panel(const view_t* v) {
+  int line = gl_get_char_height() + 4;
+  char buf[16];
+  gl_set_target(v->panel);
+  gl_clear(GL_BLACK);
+  gl_draw_string(8, line, "SCORE", GL_WHITE);
+  snprintf(buf, sizeof(buf), "%d", v->panel_score);
+  gl_draw_string(8, 2 * line, buf, GL_WHITE);
+  gl_draw_string(8, 3 * line, "LEVEL", GL_WHITE);
+  snprintf(buf, sizeof(buf), "%d", v->panel_level);
+  gl_draw_string(8, 4 * line, buf, GL_WHITE);
+  gl_draw_string(8, 5 * line, "LINES", GL_WHITE);
+  snprintf(buf, sizeof(buf), "%d", v->panel_lines);
+  gl_draw_string(8, 6 * line, buf, GL_WHITE);
+  gl_set_target(NULL);
+}
+
+//New values for a board's panel, each buffer repaints it on its way to the front
+void draw_score(int view, unsigned int score, int level, unsigned int lines) {
+  view_t* v = &views[view];
+  v->panel_score = score;
+  v->panel_level = level;
+  v->panel_lines = lines;
+  if(v->panel) {
+    compose_panel(v);
+  }
+  damage_both(panel_rect(v));
+}
+
+//Applies one change record to a board. Only the piece is taken from the records, the
+//cells are compared against the shadow, so a lock, clear or resync just marks the
+//board to be looked at. A locked piece is part of the board until the next spawns.
+void render_event(int view, const event_t* e) {
+  view_t* v = &views[view];
+  switch (e->type) {
+    case EVENT_RESYNC:
+    case EVENT_SPAWNED:
+    case EVENT_MOVED:
+    case EVENT_ROTATED:
+      v->piece = (piece_state) {e->num, e->x, e->y, e->rot};
+      v->piece_shown = true;
+      break;
+    case EVENT_LOCKED:
+      v->piece_shown = false;
+      break;
+  }
+  if(e->type == EVENT_RESYNC || e->type == EVENT_LOCKED || e->type == EVENT_CLEARED
+    || e->type == EVENT_GARBAGE) {
+    v->board_changed = true;
+  }
+  v->changed = true;
+}
+
+//Draws what changed on every board and presents them together with one swap. The
+//back buffer gets all the damage since it was last shown, the changes of this flush
+//and of the one before, which went into the other buffer. Nothing is drawn or
+//swapped when the back buffer is owed nothing.
+void render_flush(void) {
+  for(int i = 0; i < view_count; i++) {
+    view_t* v = &views[i];
+    if(!v->board || !v->changed) {
+      continue;
+    }
+    if(v->board_changed && uart_dump) {
+      dump_board(v->board);
+    }
+    update_board(v);
+    v->changed = v->board_changed = false;
+  }
+  damage_t* d = &damage[back];
+  if(!d->count) {
+    return;
+  }
+  for(int i = 0; i < view_count; i++) {
+    view_t* v = &views[i];
+    unsigned short painted[HEIGHT] = {0};
+    rect_t panel = panel_rect(v);
+    bool stamp = false;
+    for(int j = 0; j < d->count; j++) {
+      if(v->board) {
+        repaint_cells(v, d->rects[j], painted);
       }
+      stamp |= overlaps(panel, d->rects[j]);
+    }
+    if(stamp && v->panel) {
+      gl_blit(NULL, panel.x, panel.y, v->panel, 0, 0, panel.w, panel.h);
+      stats.pixels += area(panel);
     }
   }
-  // prev_piece.num = piece.num;
-  // prev_piece.x = piece.x;
-  // prev_piece.y = piece.y;
-  // prev_piece.rot = piece.rot;
-  prev_piece = piece;
+  d->count = 0;
+  gl_swap_buffer();
+  back = !back;
+  stats.presents++;
 }
 
+//Board a view draws, its records come in through render_event
+void render_attach(int view, const board_t* board) {
+  views[view].board = board;
+}
 
-void graphics_init(void) {
-  gl_init(WIDTH * 50, HEIGHT * 50, GL_DOUBLEBUFFER);
+void render_uart_dump(bool on) {
+  uart_dump = on;
+}
+
+render_stats_t render_get_stats(void) {
+  return stats;
+}
+
+//Halfway to white and halfway to black
+static color_t lighter(color_t c) {
+  return GL_BLACK | (((c & 0xFEFEFE) >> 1) + 0x7F7F7F);
+}
+
+static color_t darker(color_t c) {
+  return GL_BLACK | ((c & 0xFEFEFE) >> 1);
+}
+
+//Draws each tile with a bevel a tenth of the cell wide, lit from the top left. The
+//edges meet on the diagonals, the top right and bottom left corners going dark.
+static void make_tiles(int cell) {
+  if(tiles && tiles->height != cell) {
+    gl_surface_free(tiles);
+    tiles = NULL;
+  }
+  if(!tiles) {
+    tiles = gl_surface_create((NUM_PIECES + 2) * cell, cell);
+  }
+  if(!tiles) {
+    return;
+  }
+  gl_set_target(tiles);
+  int bevel = cell / 10;
+  for(int i = 0; i < NUM_PIECES + 2; i++) {
+    color_t c = piece_colors[i];
+    for(int y = 0; y < cell; y++) {
+      for(int x = 0; x < cell; x++) {
+        int lit = x < y ? x : y;
+        int shaded = cell - 1 - (x > y ? x : y);
+        color_t pixel = c;
+        if(lit < bevel && lit < shaded) {
+          pixel = lighter(c);
+        } else if(shaded < bevel || lit < bevel) {
+          pixel = darker(c);
+        }
+        gl_draw_pixel(i * cell + x, y, pixel);
+      }
+    }
+  }
+  gl_set_target(NULL);
+}
+
+//Splits the screen between boards side by side, each with its panel. Cells stay at
+//CELL_SIZE unless the boards would not fit. Both buffers start black, which the
+//empty shadows already say, so each is owed only its panels and filled cells. The
+//tiles are drawn off screen here, once for the match, each panel when it changes.
+void graphics_init(int boards) {
+  if(boards > MAX_VIEWS) {
+    boards = MAX_VIEWS;
+  }
+  int cell = (MAX_SCREEN_WIDTH / boards - PANEL_WIDTH) / WIDTH;
+  if(cell > CELL_SIZE) {
+    cell = CELL_SIZE;
+  }
+  cell_colors[0] = GL_BLACK;
+  for(int i = 0; i < NUM_PIECES + 2; i++) {
+    cell_colors[i + 1] = piece_colors[i];
+  }
+  for(int i = 0; i < NUM_PIECES; i++) {
+    cell_colors[GHOST + i] = GL_BLACK | ((piece_colors[i] >> 2) & 0x3F3F3F);
+  }
+  view_count = boards;
+  damage[0].count = damage[1].count = 0;
+  back = 0;
+  for(int i = 0; i < boards; i++) {
+    view_t* v = &views[i];
+    v->x = i * (WIDTH * cell + PANEL_WIDTH);
+    v->y = 0;
+    v->cell = cell;
+    for(int y = 0; y < HEIGHT; y++) {
+      for(int x = 0; x < WIDTH; x++) {
+        v->shadow[y][x] = 0;
+      }
+    }
+    v->changed = v->board_changed = true;
+    damage_both(panel_rect(v));
+  }
+  gl_init(boards * (WIDTH * cell + PANEL_WIDTH), HEIGHT * cell, GL_DOUBLEBUFFER);
+  gl_clear(GL_BLACK);
+  gl_swap_buffer();
+  gl_clear(GL_BLACK);
+  make_tiles(cell);
+  for(int i = 0; i < boards; i++) {
+    view_t* v = &views[i];
+    if(!v->panel) {
+      v->panel = gl_surface_create(PANEL_WIDTH, panel_rect(v).h);
+    }
+    if(v->panel) {
+      compose_panel(v);
+    }
+  }
 }
@@ -0,0 +1,104 @@
+#include "replay.h"
+#include "printf.h"
+
+//longest varint, a 32-bit gap and the input code take 35 bits
+#define MAX_RECORD 5
+#define INPUT_BITS 3
+
+//scratch game for moving the base forward, too big for the stack on the Pi
+static game_state_t scratch;
+
+//Starts an empty log from the current state, the seed is only kept for the dump
+void replay_init(replay_log_t* log, const game_state_t* state, unsigned int seed) {
+  log->seed = seed;
+  snapshot_save(state, &log->base);
+  log->head = log->tail = 0;
+  log->next_tick = state->tick;
+  log->records = 0;
+}
+
+//Decodes the record at *pos, its tick counts from *tick, and moves both past it
+bool replay_next(const replay_log_t* log, unsigned int* pos, unsigned int* tick, input_t* input) {
+  if(*pos == log->tail) {
+    return false;
+  }
+  unsigned int value = 0;
+  for(int shift = 0; ; shift += 7) {
+    unsigned char byte = log->bytes[(*pos)++ % REPLAY_RING];
+    value |= (byte & 0x7F) << shift;
+    if(!(byte & 0x80)) {
+      break;
+    }
+  }
+  *tick += value >> INPUT_BITS;
+  *input = value & ((1 << INPUT_BITS) - 1);
+  return true;
+}
+
+//Plays the first records forward from the base until half the ring is free and
+//saves where they left off as the new base. Runs once every few thousand inputs.
+static void drop_oldest(replay_log_t* log) {
+  snapshot_restore(&scratch, &log->base);
+  unsigned int tick = scratch.tick;
+  input_t input;
+  while(log->tail - log->head > REPLAY_RING / 2 && replay_next(log, &log->head, &tick, &input)) {
+    while(scratch.tick < tick && !scratch.game_over) {
+      core_step(&scratch, INPUT_NONE);
+    }
+    core_step(&scratch, input);
+    tick++;
+    log->records--;
+  }
+  snapshot_save(&scratch, &log->base);
+}
+
+//Call with the input just before core_step applies it
+void replay_record(replay_log_t* log, const game_state_t* state, input_t input) {
+  if(REPLAY_RING - (log->tail - log->head) < MAX_RECORD) {
+    drop_oldest(log);
+  }
+  unsigned int value = (state->tick - log->next_tick) << INPUT_BITS | input;
+  do {
+    unsigned char byte = value & 0x7F;
+    value >>= 7;
+    log->bytes[log->tail++ % REPLAY_RING] = byte | (value ? 0x80 : 0);
+  } while(value);
+  log->next_tick = state->tick + 1;
+  log->records++;
+}
+
+//Restores the base into state and plays every record, then runs on to end_tick
+void replay_run(const replay_log_t* log, game_state_t* state, unsigned int end_tick) {
+  snapshot_restore(state, &log->base);
+  unsigned int pos = log->head, tick = state->tick;
+  input_t input;
+  while(replay_next(log, &pos, &tick, &input)) {
+    while(state->tick < tick && !state->game_over) {
+      core_step(state, INPUT_NONE);
+    }
+    core_step(state, input);
+    tick++;
+  }
+  while(state->tick < end_tick && !state->game_over) {
+    core_step(state, INPUT_NONE);
+  }
+}
+
+//Prints the log as text for host/replay, with the tick and hash the game is at now
+//so the replay can be checked against it
+void replay_dump(const replay_log_t* log, const game_state_t* state) {
+  printf("REPLAY %x %x %x %x\n", log->seed, state->tick, core_hash(state), log->records);
+  for(int i = 0; i < SNAPSHOT_WORDS; i++) {
+    printf("%x ", log->base.words[i]);
+  }
+  printf("\n");
+  int column = 0;
+  for(unsigned int pos = log->head; pos != log->tail; pos++) {
+    printf("%02x", log->bytes[pos % REPLAY_RING]);
+    if(++column == 32) {
+      printf("\n");
+      column = 0;
+    }
+  }
+  printf("\nEND\n");
+}
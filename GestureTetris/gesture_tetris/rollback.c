@@ -0,0 +1,157 @@
+#include "rollback.h"
+#include "strings.h"
+
+#define SLOT(t) ((t) % ROLLBACK_RING)
+
+//rows of garbage sent for clearing one to four rows at once
+static const unsigned char garbage_rows[5] = {0, 0, 1, 2, 4};
+
+//Both players get the same pieces, the seed is agreed before the match starts
+void rollback_init(rollback_t* r, game_state_t* local_game, game_state_t* remote_game, int local, unsigned int seed) {
+  r->local = local;
+  r->games[local] = local_game;
+  r->games[!local] = remote_game;
+  core_init(r->games[0], seed);
+  core_init(r->games[1], seed);
+  r->tick = r->confirmed = r->given = r->acked = 0;
+  rollback_stats_t zero = {0};
+  r->stats = zero;
+}
+
+//Keeps player p's game before tick t, colors and all
+static void save_game(rollback_t* r, int p, unsigned int t) {
+  snapshot_save(r->games[p], &r->snaps[SLOT(t)][p]);
+  memcpy(r->cells[SLOT(t)][p], r->games[p]->board.cells, sizeof(r->cells[0][0]));
+}
+
+//Puts player p's game back to before tick t
+static void restore_game(rollback_t* r, int p, unsigned int t) {
+  snapshot_restore(r->games[p], &r->snaps[SLOT(t)][p]);
+  memcpy(r->games[p]->board.cells, r->cells[SLOT(t)][p], sizeof(r->cells[0][0]));
+}
+
+//Steps player p's game through tick t and returns the garbage its clears send. The
+//hole column comes from the piece generator's state, so it changes clear to clear.
+static unsigned char step_game(rollback_t* r, int p, unsigned int t) {
+  game_state_t* game = r->games[p];
+  unsigned int lines = game->lines;
+  core_step(game, r->inputs[SLOT(t)][p]);
+  unsigned int rows = garbage_rows[game->lines - lines];
+  if(!rows) {
+    return 0;
+  }
+  return rows | (((game->randomizer.rng >> 16) * WIDTH) >> 16) << 4;
+}
+
+//Simulates tick t for the games in mask, the others already hold its outcome. A game
+//whose garbage came out different drags the other back into the mask, since what it
+//was sent at t has changed. Returns the games still being simulated.
+static int simulate(rollback_t* r, unsigned int t, int mask) {
+  unsigned char* sent = r->garbage[SLOT(t)];
+  int stepping = mask;
+  for(int p = 0; p < 2; p++) {
+    if(stepping & (1 << p)) {
+      save_game(r, p, t);
+      unsigned char was = sent[p];
+      sent[p] = step_game(r, p, t);
+      if(sent[p] != was && !(mask & (1 << !p))) {
+        //its own step at t does not depend on what it is sent at t
+        restore_game(r, !p, t);
+        step_game(r, !p, t);
+        mask |= 1 << !p;
+      }
+    }
+  }
+  //garbage rises at the next lock, both have stepped so the order does not matter
+  for(int p = 0; p < 2; p++) {
+    if(sent[p] && (mask & (1 << !p))) {
+      core_queue_garbage(r->games[!p], sent[p] & 0xF, sent[p] >> 4);
+    }
+  }
+  return mask;
+}
+
+//Runs the match one tick with this side's input and returns whether it took it. It
+//does nothing when it has to wait: a game has ended, the remote inputs are a window
+//behind, or the other side has not acked the inputs the ring would drop. A tick run
+//before, that an ending a rollback undid cut off, keeps the input it had then, since
+//the other side may have it already.
+bool rollback_tick(rollback_t* r, input_t input) {
+  if(r->games[0]->game_over || r->games[1]->game_over) {
+    return false;
+  }
+  if(r->tick >= r->confirmed + ROLLBACK_WINDOW || r->given >= r->acked + ROLLBACK_RING) {
+    r->stats.stalls++;
+    return false;
+  }
+  bool taken = r->tick == r->given;
+  unsigned char* inputs = r->inputs[SLOT(r->tick)];
+  if(taken) {
+    inputs[r->local] = input;
+    r->given++;
+  }
+  if(r->tick >= r->confirmed) {
+    inputs[!r->local] = INPUT_NONE;
+  }
+  simulate(r, r->tick, 3);
+  r->tick++;
+  return taken;
+}
+
+//Takes remote inputs for ticks start on, in order. Inputs already known are skipped
+//and anything after a gap waits for the resend. If a guess was wrong, the remote game
+//goes back to the first wrong tick and catches up with the inputs now known.
+void rollback_receive(rollback_t* r, unsigned int start, const unsigned char* inputs, int count) {
+  int remote = !r->local;
+  unsigned int redo = r->tick;
+  for(int i = 0; i < count; i++) {
+    unsigned int t = start + i;
+    if(t < r->confirmed) {
+      continue;
+    }
+    //the slot still holds an input a rollback could need
+    if(t > r->confirmed || t >= r->tick + ROLLBACK_RING - ROLLBACK_WINDOW) {
+      break;
+    }
+    input_t input = inputs[i] <= INPUT_ROTATE_180 ? inputs[i] : INPUT_NONE;
+    unsigned char* guess = &r->inputs[SLOT(t)][remote];
+    if(t < r->tick && *guess != input && redo == r->tick) {
+      redo = t;
+    }
+    *guess = input;
+    r->confirmed++;
+  }
+  if(redo == r->tick) {
+    return;
+  }
+  r->stats.rollbacks++;
+  if(r->tick - redo > r->stats.deepest) {
+    r->stats.deepest = r->tick - redo;
+  }
+  restore_game(r, remote, redo);
+  int mask = 1 << remote;
+  for(unsigned int t = redo; t < r->tick; t++) {
+    mask = simulate(r, t, mask);
+    r->stats.resimulated += mask == 3 ? 2 : 1;
+    //the match stops on the tick a game ends, as it would have with no guessing.
+    //Local inputs past it stay given in case a later rollback undoes the ending.
+    if((r->games[0]->game_over || r->games[1]->game_over) && t + 1 < r->tick) {
+      for(int p = 0; p < 2; p++) {
+        if(!(mask & (1 << p))) {
+          restore_game(r, p, t + 1);
+        }
+      }
+      r->tick = t + 1;
+    }
+  }
+}
+
+//Local input given at tick, for sending on. Only ticks from acked to given are kept.
+input_t rollback_local_input(const rollback_t* r, unsigned int tick) {
+  return r->inputs[SLOT(tick)][r->local];
+}
+
+//A game has ended on inputs that are all known, so no late input can change it
+bool rollback_over(const rollback_t* r) {
+  return (r->games[0]->game_over || r->games[1]->game_over) && r->confirmed >= r->tick;
+}
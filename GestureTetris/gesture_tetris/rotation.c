@@ -0,0 +1,85 @@
+#include "rotation.h"
+
+typedef struct {
+  unsigned char count;
+  signed char offsets[MAX_KICKS][2];    //x, y with y pointing down the board
+} kick_list;
+
+//SRS kicks from tetris.wiki/Super_Rotation_System with y flipped to point down,
+//indexed by the starting rotation then by turn: clockwise, 180, counter-clockwise.
+//The 180 kicks are the common SRS+ set, which SRS itself does not define.
+static const kick_list jlstz_kicks[4][3] = {
+  { //from 0
+    {5, {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}}},
+    {6, {{0, 0}, {0, -1}, {1, -1}, {-1, -1}, {1, 0}, {-1, 0}}},
+    {5, {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}}},
+  },
+  { //from R
+    {5, {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}}},
+    {6, {{0, 0}, {1, 0}, {1, -2}, {1, -1}, {0, -2}, {0, -1}}},
+    {5, {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}}},
+  },
+  { //from 2
+    {5, {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}}},
+    {6, {{0, 0}, {0, 1}, {-1, 1}, {1, 1}, {-1, 0}, {1, 0}}},
+    {5, {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}}},
+  },
+  { //from L
+    {5, {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}}},
+    {6, {{0, 0}, {-1, 0}, {-1, -2}, {-1, -1}, {0, -2}, {0, -1}}},
+    {5, {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}}},
+  },
+};
+
+static const kick_list i_kicks[4][3] = {
+  { //from 0
+    {5, {{0, 0}, {-2, 0}, {1, 0}, {-2, 1}, {1, -2}}},
+    {6, {{0, 0}, {0, -1}, {1, -1}, {-1, -1}, {1, 0}, {-1, 0}}},
+    {5, {{0, 0}, {-1, 0}, {2, 0}, {-1, -2}, {2, 1}}},
+  },
+  { //from R
+    {5, {{0, 0}, {-1, 0}, {2, 0}, {-1, -2}, {2, 1}}},
+    {6, {{0, 0}, {1, 0}, {1, -2}, {1, -1}, {0, -2}, {0, -1}}},
+    {5, {{0, 0}, {2, 0}, {-1, 0}, {2, -1}, {-1, 2}}},
+  },
+  { //from 2
+    {5, {{0, 0}, {2, 0}, {-1, 0}, {2, -1}, {-1, 2}}},
+    {6, {{0, 0}, {0, 1}, {-1, 1}, {1, 1}, {-1, 0}, {1, 0}}},
+    {5, {{0, 0}, {1, 0}, {-2, 0}, {1, 2}, {-2, -1}}},
+  },
+  { //from L
+    {5, {{0, 0}, {1, 0}, {-2, 0}, {1, 2}, {-2, -1}}},
+    {6, {{0, 0}, {-1, 0}, {-1, -2}, {-1, -1}, {0, -2}, {0, -1}}},
+    {5, {{0, 0}, {-2, 0}, {1, 0}, {-2, 1}, {1, -2}}},
+  },
+};
+
+//the O looks the same in every rotation and never kicks
+static const kick_list no_kick = {1, {{0, 0}}};
+
+//Turns the piece by the given quarter turns clockwise, trying each kick offset of the
+//rotation in order. Returns false and leaves the piece alone if every offset collides,
+//so a rotation never costs more than MAX_KICKS collision checks.
+bool rotate_piece(const board_t* board, piece_state* piece, int turns) {
+  int rot = (piece->rot + turns) & 3;
+  const kick_list* kicks;
+  if(piece->num == PIECE_O) {
+    kicks = &no_kick;
+  } else if(piece->num == PIECE_I) {
+    kicks = &i_kicks[piece->rot][turns - 1];
+  } else {
+    kicks = &jlstz_kicks[piece->rot][turns - 1];
+  }
+  const piece_geometry* geom = &piece_table[piece->num][rot];
+  for(int i = 0; i < kicks->count; i++) {
+    int x = piece->x + kicks->offsets[i][0];
+    int y = piece->y + kicks->offsets[i][1];
+    if(!board_collides(board, geom, x, y)) {
+      piece->x = x;
+      piece->y = y;
+      piece->rot = rot;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,50 @@
+#include "serial.h"
+#include "interrupts.h"
+
+//mini UART registers, uart_init has already set the baud rate
+static volatile unsigned int* const AUX_IRQ = (unsigned int*) 0x20215000;
+static volatile unsigned int* const MU_IO = (unsigned int*) 0x20215040;
+static volatile unsigned int* const MU_IER = (unsigned int*) 0x20215044;
+static volatile unsigned int* const MU_LSR = (unsigned int*) 0x20215054;
+
+//The datasheet has the enable bits swapped, bit 0 is receive and bit 1 transmit,
+//and receive interrupts also need bits 2 and 3 set
+#define IER_RX 0x0D
+#define IER_TX 0x02
+
+#define LSR_DATA_READY 0x01
+#define LSR_TX_ROOM 0x20
+
+static link_t* serial_link;
+
+//Empties the receive FIFO into rx, then fills the transmit FIFO from tx and stops
+//the transmit interrupt once tx runs dry
+static bool handle_serial(unsigned int pc) {
+  if(!(*AUX_IRQ & 1)) {
+    return false;
+  }
+  while(*MU_LSR & LSR_DATA_READY) {
+    link_rx_put(serial_link, *MU_IO & 0xFF);
+  }
+  unsigned char byte;
+  while(*MU_LSR & LSR_TX_ROOM) {
+    if(!link_tx_get(serial_link, &byte)) {
+      *MU_IER = IER_RX;
+      break;
+    }
+    *MU_IO = byte;
+  }
+  return true;
+}
+
+void serial_init(link_t* link) {
+  link_init(link, serial_kick);
+  serial_link = link;
+  interrupts_attach_handler(handle_serial, INTERRUPTS_AUX);
+  *MU_IER = IER_RX;
+}
+
+//Turns on the transmit interrupt, which fires as soon as the FIFO has room
+void serial_kick(void) {
+  *MU_IER = IER_RX | IER_TX;
+}
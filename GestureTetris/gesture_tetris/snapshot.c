@@ -0,0 +1,129 @@
+#include "snapshot.h"
+
+//A floor kick can lift a piece whose top rows are empty above row 0, as far as -3,
+//so its y is stored with this added to keep the field unsigned
+#define PIECE_Y_BIAS 4
+
+//Writes and reads bit fields in order, low bits of each word first. A field never
+//spans more than two words, so each one is a shift or two.
+typedef struct {
+  unsigned int* words;
+  int bit;
+} packer;
+
+static void put(packer* p, unsigned int value, int bits) {
+  int word = p->bit >> 5, shift = p->bit & 31;
+  if(bits < 32) {
+    value &= (1u << bits) - 1;
+  }
+  p->words[word] |= value << shift;
+  if(shift + bits > 32) {
+    p->words[word + 1] |= value >> (32 - shift);
+  }
+  p->bit += bits;
+}
+
+static unsigned int get(packer* p, int bits) {
+  int word = p->bit >> 5, shift = p->bit & 31;
+  unsigned int value = p->words[word] >> shift;
+  if(shift + bits > 32) {
+    value |= p->words[word + 1] << (32 - shift);
+  }
+  if(bits < 32) {
+    value &= (1u << bits) - 1;
+  }
+  p->bit += bits;
+  return value;
+}
+
+void snapshot_save(const game_state_t* state, snapshot_t* snap) {
+  for(int i = 0; i < SNAPSHOT_WORDS; i++) {
+    snap->words[i] = 0;
+  }
+  packer p = {snap->words, 0};
+  for(int y = 0; y < HEIGHT; y++) {
+    put(&p, state->board.rows[y] >> BOARD_PAD, WIDTH);
+  }
+  //x runs from -BOARD_PAD and y from -3
+  const piece_state* cur = &state->cur_piece;
+  put(&p, cur->num, 3);
+  put(&p, cur->rot, 2);
+  put(&p, cur->x + BOARD_PAD, 5);
+  put(&p, cur->y + PIECE_Y_BIAS, 5);
+  //only the pieces still in the bag and the preview in the order they come out
+  const randomizer_t* r = &state->randomizer;
+  put(&p, r->rng, 32);
+  put(&p, r->bag_left, 3);
+  for(int i = 0; i < NUM_PIECES; i++) {
+    put(&p, i < r->bag_left ? r->bag[i] : 0, 3);
+  }
+  for(int i = 0; i < PREVIEW_DEPTH; i++) {
+    put(&p, randomizer_peek(r, i), 3);
+  }
+  put(&p, state->tick, 32);
+  put(&p, state->level, 5);
+  put(&p, state->fall, 16);
+  put(&p, state->lock_timer, 5);
+  put(&p, state->lock_resets, 4);
+  put(&p, state->lowest_y, 5);
+  put(&p, state->pieces, 32);
+  put(&p, state->lines, 32);
+  put(&p, state->score, 32);
+  put(&p, state->goal, 32);
+  put(&p, state->garbage, 5);
+  put(&p, state->garbage_hole, 4);
+  put(&p, state->game_over, 1);
+}
+
+//Puts the game back where snap was taken. The blob has no colors, so a filled cell
+//keeps the color state's board already has there and only cells empty now come
+//back as CELL_RESTORED. Consumers get a resync to redraw from.
+void snapshot_restore(game_state_t* state, const snapshot_t* snap) {
+  packer p = {(unsigned int*) snap->words, 0};
+  board_t* board = &state->board;
+  for(int y = 0; y < HEIGHT; y++) {
+    unsigned int mask = get(&p, WIDTH);
+    board->rows[y] = ROW_EMPTY | (mask << BOARD_PAD);
+    for(int x = 0; x < WIDTH; x++) {
+      if(!(mask & (1 << x))) {
+        board->cells[y][x] = 0;
+      } else if(!board->cells[y][x]) {
+        board->cells[y][x] = CELL_RESTORED;
+      }
+    }
+  }
+  //state may never have held a game, so the floor is put back as well
+  for(int y = HEIGHT; y < HEIGHT + BOARD_FLOOR; y++) {
+    board->rows[y] = ROW_FULL;
+  }
+  board_refresh(board);
+  piece_state* cur = &state->cur_piece;
+  cur->num = get(&p, 3);
+  cur->rot = get(&p, 2);
+  cur->x = (int) get(&p, 5) - BOARD_PAD;
+  cur->y = (int) get(&p, 5) - PIECE_Y_BIAS;
+  randomizer_t* r = &state->randomizer;
+  r->rng = get(&p, 32);
+  r->bag_left = get(&p, 3);
+  for(int i = 0; i < NUM_PIECES; i++) {
+    r->bag[i] = get(&p, 3);
+  }
+  r->head = 0;
+  for(int i = 0; i < PREVIEW_DEPTH; i++) {
+    r->preview[i] = get(&p, 3);
+  }
+  state->tick = get(&p, 32);
+  core_set_level(state, get(&p, 5));
+  state->fall = get(&p, 16);
+  state->lock_timer = get(&p, 5);
+  state->lock_resets = get(&p, 4);
+  state->lowest_y = get(&p, 5);
+  state->pieces = get(&p, 32);
+  state->lines = get(&p, 32);
+  state->score = get(&p, 32);
+  state->goal = get(&p, 32);
+  state->garbage = get(&p, 5);
+  state->garbage_hole = get(&p, 4);
+  state->game_over = get(&p, 1);
+  events_init(&state->events);
+}
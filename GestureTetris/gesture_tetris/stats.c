@@ -0,0 +1,28 @@
+#include "stats.h"
+#include "printf.h"
+
+void stats_init(stats_t* stats) {
+  for(int i = 0; i < NUM_EVENTS; i++) {
+    stats->counts[i] = 0;
+  }
+  for(int i = 0; i <= MAX_CLEAR; i++) {
+    stats->clears[i] = 0;
+  }
+  stats->lines = 0;
+}
+
+void stats_event(stats_t* stats, const event_t* e) {
+  stats->counts[e->type]++;
+  if(e->type == EVENT_CLEARED && e->lines <= MAX_CLEAR) {
+    stats->clears[e->lines]++;
+    stats->lines += e->lines;
+  }
+}
+
+void stats_print(const stats_t* stats) {
+  printf("pieces %d lines %d\n", stats->counts[EVENT_LOCKED], stats->lines);
+  printf("singles %d doubles %d triples %d tetrises %d\n",
+    stats->clears[1], stats->clears[2], stats->clears[3], stats->clears[4]);
+  printf("moves %d rotations %d resyncs %d\n",
+    stats->counts[EVENT_MOVED], stats->counts[EVENT_ROTATED], stats->counts[EVENT_RESYNC]);
+}
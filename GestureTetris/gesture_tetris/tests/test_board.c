@@ -4,13 +4,624 @@
 #include "uart.h"
 #include "timer.h"
 #include "game.h"
+#include "board.h"
+#include "rotation.h"
+#include "snapshot.h"
+#include "replay.h"
+#include "link.h"
+#include "rollback.h"
+#include "versus.h"
+#include "ai.h"
 
+static board_t test;
+
+static void test_tables(void)
+{
+    const piece_geometry* t = &piece_table[PIECE_T][0];
+    assert(t->rows[0] == 0b010);
+    assert(t->rows[1] == 0b111);
+    assert(t->rows[2] == 0);
+    assert(t->left == 0 && t->right == 2);
+    assert(t->top == 0 && t->bottom == 1);
+    assert(t->col_bottom[0] == 1 && t->col_bottom[1] == 1 && t->col_bottom[3] == -1);
+    assert(t->cells[0][0] == 1 && t->cells[0][1] == 0);
+
+    const piece_geometry* i = &piece_table[PIECE_I][1];
+    for(int y = 0; y < 4; y++) {
+        assert(i->rows[y] == 0b100);
+        assert(i->cells[y][0] == 2 && i->cells[y][1] == y);
+    }
+    assert(i->col_bottom[2] == 3);
+
+    //every rotation has exactly the cells its row masks describe
+    for(int num = 0; num < NUM_PIECES; num++) {
+        for(int rot = 0; rot < 4; rot++) {
+            const piece_geometry* g = &piece_table[num][rot];
+            int bits = 0;
+            for(int y = 0; y < 4; y++) {
+                for(int x = 0; x < 4; x++) {
+                    bits += (g->rows[y] >> x) & 1;
+                }
+            }
+            assert(bits == 4);
+            for(int c = 0; c < 4; c++) {
+                assert(g->rows[g->cells[c][1]] & (1 << g->cells[c][0]));
+            }
+        }
+    }
+}
+
+static void test_collides(void)
+{
+    const piece_geometry* t = &piece_table[PIECE_T][0];
+    board_init(&test);
+
+    //walls
+    assert(!board_collides(&test, t, 0, 0));
+    assert(board_collides(&test, t, -1, 0));
+    assert(!board_collides(&test, t, WIDTH - 3, 0));
+    assert(board_collides(&test, t, WIDTH - 2, 0));
+
+    //floor
+    assert(!board_collides(&test, t, 4, HEIGHT - 2));
+    assert(board_collides(&test, t, 4, HEIGHT - 1));
+
+    //empty columns of the 4x4 may hang over the wall
+    const piece_geometry* i = &piece_table[PIECE_I][1];
+    assert(!board_collides(&test, i, -2, 0));
+    assert(board_collides(&test, i, -3, 0));
+
+    //other pieces
+    board_place(&test, t, 4, HEIGHT - 2, 1);
+    assert(test.cells[HEIGHT - 1][4] == 1);
+    assert(test.cells[HEIGHT - 2][5] == 1);
+    assert(test.cells[HEIGHT - 2][4] == 0);
+    assert(board_collides(&test, t, 4, HEIGHT - 3));
+    assert(!board_collides(&test, t, 4, HEIGHT - 4));
+    assert(!board_collides(&test, t, 0, HEIGHT - 2));
+}
+
+static void test_lines(void)
+{
+    const piece_geometry* i = &piece_table[PIECE_I][0];
+    board_init(&test);
+
+    board_place(&test, i, 0, HEIGHT - 2, 1);
+    board_place(&test, i, 4, HEIGHT - 2, 1);
+    assert(!board_is_line(&test, HEIGHT - 1));
+
+    board_place(&test, &piece_table[PIECE_O][0], 7, HEIGHT - 2, 5);
+    assert(board_is_line(&test, HEIGHT - 1));
+    assert(!board_is_line(&test, HEIGHT - 2));
+}
+
+static void test_counters(void)
+{
+    board_init(&test);
+
+    //T pointing down in the bottom corner
+    unsigned int lines = board_place(&test, &piece_table[PIECE_T][2], 0, HEIGHT - 3, 7);
+    assert(lines == 0);
+    assert(test.row_fill[HEIGHT - 2] == 3);
+    assert(test.row_fill[HEIGHT - 1] == 1);
+    assert(test.col_height[0] == 2 && test.col_height[1] == 2 && test.col_height[2] == 2);
+    assert(test.col_height[3] == 0);
+    assert(test.height == 2);
+
+    //fill the rest of the row with one flat and three upright Is
+    assert(board_place(&test, &piece_table[PIECE_I][0], 3, HEIGHT - 3, 1) == 0);
+    assert(board_place(&test, &piece_table[PIECE_I][1], 5, HEIGHT - 5, 1) == 0);
+    assert(board_place(&test, &piece_table[PIECE_I][3], 7, HEIGHT - 5, 1) == 0);
+    assert(test.row_fill[HEIGHT - 2] == 9);
+    lines = board_place(&test, &piece_table[PIECE_I][1], 7, HEIGHT - 5, 1);
+    assert(lines == 1 << (HEIGHT - 2));
+    assert(test.row_fill[HEIGHT - 1] == 1);
+    assert(test.col_height[8] == 5);
+    assert(test.height == 5);
+    assert(!board_topped_out(&test));
+
+    //stacking into the spawn rows tops out
+    board_place(&test, &piece_table[PIECE_I][1], 7, 0, 1);
+    assert(test.height == HEIGHT);
+    assert(board_topped_out(&test));
+}
+
+static void test_drop(void)
+{
+    const piece_geometry* t = &piece_table[PIECE_T][0];
+    board_init(&test);
+    assert(board_drop_distance(&test, t, 3, 0) == HEIGHT - 2);
+    assert(board_drop_distance(&test, t, 3, HEIGHT - 2) == 0);
+
+    //lands on the tallest column under it
+    board_place(&test, &piece_table[PIECE_I][1], 2, HEIGHT - 4, 1);
+    assert(board_drop_distance(&test, t, 3, 0) == HEIGHT - 6);
+    assert(board_drop_distance(&test, t, 5, 0) == HEIGHT - 2);
+    assert(!board_collides(&test, t, 3, HEIGHT - 6));
+    assert(board_collides(&test, t, 3, HEIGHT - 5));
+
+    //tucked under an overhang it falls to the floor
+    board_init(&test);
+    board_place(&test, &piece_table[PIECE_I][0], 0, HEIGHT - 6, 1);
+    assert(board_drop_distance(&test, &piece_table[PIECE_O][0], -1, HEIGHT - 4) == 2);
+    assert(board_drop_distance(&test, &piece_table[PIECE_O][0], -1, 0) == HEIGHT - 7);
+}
+
+static void test_clear(void)
+{
+    board_init(&test);
+
+    //rows 19 and 17 full, 18 and 16 only have columns 4 to 9, an O sits on top
+    for(int x = 4; x < WIDTH; x++) {
+        board_place(&test, &piece_table[PIECE_I][1], x - 2, HEIGHT - 4, 1);
+    }
+    board_place(&test, &piece_table[PIECE_I][0], 0, HEIGHT - 2, 2);
+    board_place(&test, &piece_table[PIECE_I][0], 0, HEIGHT - 4, 2);
+    board_place(&test, &piece_table[PIECE_O][0], -1, HEIGHT - 6, 5);
+    assert(board_is_line(&test, HEIGHT - 1));
+    assert(!board_is_line(&test, HEIGHT - 2));
+    assert(board_is_line(&test, HEIGHT - 3));
+    assert(test.height == 6);
+
+    unsigned int lines = (1 << (HEIGHT - 1)) | (1 << (HEIGHT - 3));
+    row_range dirty = board_clear_lines(&test, lines);
+    assert(dirty.top == HEIGHT - 6);
+    assert(dirty.bottom == HEIGHT - 1);
+
+    //surviving rows moved down past both cleared rows at once
+    assert(test.cells[HEIGHT - 1][5] == 1 && test.cells[HEIGHT - 1][0] == 0);
+    assert(test.row_fill[HEIGHT - 1] == 6 && test.row_fill[HEIGHT - 2] == 6);
+    assert(test.cells[HEIGHT - 3][0] == 5 && test.cells[HEIGHT - 4][1] == 5);
+    assert(test.row_fill[HEIGHT - 3] == 2);
+    assert(test.row_fill[HEIGHT - 5] == 0 && test.row_fill[HEIGHT - 6] == 0);
+    assert(test.rows[HEIGHT - 5] == ROW_EMPTY);
+    assert(test.cells[HEIGHT - 6][0] == 0);
+    assert(test.col_height[0] == 4 && test.col_height[5] == 2 && test.col_height[2] == 0);
+    assert(test.height == 4);
+
+    dirty = board_clear_lines(&test, 0);
+    assert(dirty.top > dirty.bottom);
+}
+
+static void test_rotation(void)
+{
+    board_init(&test);
+
+    //upright I against the left wall kicks two columns right
+    piece_state piece = {PIECE_I, -2, 5, 1};
+    assert(rotate_piece(&test, &piece, TURN_CW));
+    assert(piece.rot == 2 && piece.x == 0 && piece.y == 5);
+    assert(rotate_piece(&test, &piece, TURN_CCW));
+    assert(piece.rot == 1);
+
+    //T flipped on the floor kicks up a row
+    piece = (piece_state) {PIECE_T, 3, HEIGHT - 2, 0};
+    assert(rotate_piece(&test, &piece, TURN_180));
+    assert(piece.rot == 2 && piece.x == 3 && piece.y == HEIGHT - 3);
+
+    //O never moves
+    piece = (piece_state) {PIECE_O, 3, 3, 0};
+    assert(rotate_piece(&test, &piece, TURN_CW));
+    assert(piece.rot == 1 && piece.x == 3 && piece.y == 3);
+
+    //boxed in on both sides, every kick collides and the piece stays put
+    for(int y = HEIGHT - 4; y < HEIGHT; y++) {
+        test.rows[y] = ROW_FULL & ~(1 << (4 + BOARD_PAD));
+    }
+    piece = (piece_state) {PIECE_I, 2, HEIGHT - 4, 1};
+    assert(!board_collides(&test, &piece_table[PIECE_I][1], piece.x, piece.y));
+    assert(!rotate_piece(&test, &piece, TURN_CW));
+    assert(piece.rot == 1 && piece.x == 2 && piece.y == HEIGHT - 4);
+}
+
+static game_state_t state;
+
+static void test_gravity(void)
+{
+    //level 1 falls a row every 30 ticks
+    core_init(&state, 1);
+    int start = state.cur_piece.y;
+    for(int i = 0; i < 29; i++) {
+        core_step(&state, INPUT_NONE);
+    }
+    assert(state.cur_piece.y == start);
+    core_step(&state, INPUT_NONE);
+    assert(state.cur_piece.y == start + 1);
+
+    //20G lands on the first tick and waits out the lock delay there
+    core_init(&state, 1);
+    core_set_level(&state, MAX_LEVEL);
+    assert(state.gravity == MAX_GRAVITY);
+    int land = landing_y(&state, state.cur_piece);
+    core_step(&state, INPUT_NONE);
+    assert(state.cur_piece.y == land && state.pieces == 0);
+    for(int i = 0; i < LOCK_TICKS - 1; i++) {
+        core_step(&state, INPUT_NONE);
+    }
+    assert(state.pieces == 0);
+    core_step(&state, INPUT_NONE);
+    assert(state.pieces == 1);
+
+    //moving on the stack restarts the lock delay, until the resets run out
+    core_init(&state, 1);
+    core_set_level(&state, MAX_LEVEL);
+    core_step(&state, INPUT_NONE);
+    for(int i = 0; i < LOCK_TICKS - 1; i++) {
+        core_step(&state, INPUT_NONE);
+    }
+    core_step(&state, INPUT_LEFT);
+    assert(state.pieces == 0 && state.lock_resets == MAX_LOCK_RESETS - 1);
+    int ticks = 0;
+    while(state.pieces == 0) {
+        core_step(&state, ticks++ % 2 ? INPUT_LEFT : INPUT_RIGHT);
+    }
+    //the other resets, then one full lock delay with none left
+    assert(ticks == (MAX_LOCK_RESETS - 1) + (LOCK_TICKS - 1));
+
+    //levels past either end are clamped
+    core_set_level(&state, 0);
+    assert(state.level == MIN_LEVEL);
+    core_set_level(&state, MAX_LEVEL + 5);
+    assert(state.level == MAX_LEVEL);
+}
+
+static void test_events(void)
+{
+    event_t e;
+    core_init(&state, 1);
+    assert(core_next_event(&state, &e) && e.type == EVENT_RESYNC);
+    assert(e.top == 0 && e.bottom == HEIGHT - 1);
+    assert(core_next_event(&state, &e) && e.type == EVENT_SPAWNED);
+    assert(e.num == state.cur_piece.num && e.x == SPAWN_X && e.y == SPAWN_Y);
+    assert(!core_next_event(&state, &e));
+
+    //a hard drop locks where it lands and spawns the next piece
+    piece_state dropped = state.cur_piece;
+    dropped.y = landing_y(&state, dropped);
+    core_step(&state, INPUT_HARD_DROP);
+    assert(core_next_event(&state, &e) && e.type == EVENT_SCORED);
+    assert(core_next_event(&state, &e) && e.type == EVENT_LOCKED);
+    assert(e.x == dropped.x && e.y == dropped.y && e.bottom == HEIGHT - 1);
+    assert(core_next_event(&state, &e) && e.type == EVENT_SPAWNED);
+    assert(!core_next_event(&state, &e));
+
+    //overflowing the queue loses records and owes a resync after the rest
+    for(int i = 0; i < EVENT_QUEUE + 4; i++) {
+        core_step(&state, i % 2 ? INPUT_LEFT : INPUT_RIGHT);
+    }
+    int count = 0;
+    while(core_next_event(&state, &e) && e.type != EVENT_RESYNC) {
+        count++;
+    }
+    assert(count == EVENT_QUEUE && e.type == EVENT_RESYNC);
+    assert(!core_next_event(&state, &e));
+}
+
+static void test_snapshot(void)
+{
+    static game_state_t copy;
+    snapshot_t snap;
+    assert(sizeof(snapshot_t) < 100);
+
+    //play into a game with a stack, a level and a piece partway down
+    core_init(&state, 7);
+    core_set_level(&state, 5);
+    for(int i = 0; i < 200; i++) {
+        core_step(&state, i % 23 == 0 ? INPUT_HARD_DROP : i % 5 == 0 ? INPUT_LEFT : INPUT_NONE);
+    }
+    assert(!state.game_over && state.pieces > 0);
+    snapshot_save(&state, &snap);
+    unsigned int hash = core_hash(&state);
+    copy = state;
+
+    //the same inputs from the restored state play out the same game
+    for(int i = 0; i < 300; i++) {
+        core_step(&state, i % 7 == 0 ? INPUT_ROTATE_CW : i % 11 == 0 ? INPUT_HARD_DROP : INPUT_RIGHT);
+    }
+    unsigned int after = core_hash(&state);
+    snapshot_restore(&state, &snap);
+    assert(core_hash(&state) == hash);
+    for(int y = 0; y < HEIGHT; y++) {
+        assert(state.board.row_fill[y] == copy.board.row_fill[y]);
+    }
+    for(int x = 0; x < WIDTH; x++) {
+        assert(state.board.col_height[x] == copy.board.col_height[x]);
+    }
+    assert(state.board.height == copy.board.height);
+    for(int i = 0; i < PREVIEW_DEPTH; i++) {
+        assert(next_piece(&state, i) == next_piece(&copy, i));
+    }
+    for(int i = 0; i < 300; i++) {
+        core_step(&state, i % 7 == 0 ? INPUT_ROTATE_CW : i % 11 == 0 ? INPUT_HARD_DROP : INPUT_RIGHT);
+    }
+    assert(core_hash(&state) == after);
+
+    //consumers are told to redraw everything
+    event_t e;
+    snapshot_restore(&state, &snap);
+    assert(core_next_event(&state, &e) && e.type == EVENT_RESYNC);
+
+    //a state that never held a game gets its floor back too, so pieces still land
+    static game_state_t blank;
+    snapshot_restore(&blank, &snap);
+    assert(core_hash(&blank) == hash);
+    for(int y = HEIGHT; y < HEIGHT + BOARD_FLOOR; y++) {
+        assert(blank.board.rows[y] == ROW_FULL);
+    }
+    snapshot_restore(&state, &snap);
+    for(int i = 0; i < 300; i++) {
+        core_step(&state, i % 7 == 0 ? INPUT_ROTATE_CW : i % 11 == 0 ? INPUT_HARD_DROP : INPUT_RIGHT);
+        core_step(&blank, i % 7 == 0 ? INPUT_ROTATE_CW : i % 11 == 0 ? INPUT_HARD_DROP : INPUT_RIGHT);
+    }
+    assert(core_hash(&blank) == core_hash(&state));
+
+    //a kick can leave a piece whose top row is empty above the board
+    core_init(&state, 7);
+    state.cur_piece = (piece_state) {PIECE_J, 3, -1, 2};
+    assert(piece_table[PIECE_J][2].top > 0);
+    assert(!board_collides(&state.board, &piece_table[PIECE_J][2], 3, -1));
+    snapshot_save(&state, &snap);
+    hash = core_hash(&state);
+    snapshot_restore(&state, &snap);
+    assert(state.cur_piece.y == -1);
+    assert(core_hash(&state) == hash);
+}
+
+static void test_scoring(void)
+{
+    //an I dropped flat into the gap of an otherwise full bottom row
+    core_init(&state, 1);
+    state.board.rows[HEIGHT - 1] = ROW_FULL & ~(0b1111 << (SPAWN_X + BOARD_PAD));
+    board_refresh(&state.board);
+    state.cur_piece = (piece_state) {PIECE_I, SPAWN_X, SPAWN_Y, 0};
+    state.lines = 9;
+    core_set_level(&state, MIN_LEVEL);
+    assert(state.goal == 19);
+    state.goal = 10;
+    core_step(&state, INPUT_HARD_DROP);
+    assert(state.lines == 10);
+    assert(state.score == DROP_POINTS * (HEIGHT - 2 - SPAWN_Y) + 100);
+
+    //the tenth line starts level 2 and its gravity
+    assert(state.level == 2 && state.goal == 20);
+    assert(state.gravity > GRAVITY_ONE / 30);
+
+    //clears score more at higher levels
+    core_init(&state, 1);
+    core_set_level(&state, 5);
+    for(int y = HEIGHT - 4; y < HEIGHT; y++) {
+        state.board.rows[y] = ROW_FULL & ~(1 << (9 + BOARD_PAD));
+    }
+    board_refresh(&state.board);
+    state.cur_piece = (piece_state) {PIECE_I, 7, HEIGHT - 4, 1};
+    core_step(&state, INPUT_HARD_DROP);
+    assert(state.lines == 4 && state.score == 800 * 5);
+    assert(state.level == 5);
+}
+
+static replay_log_t replay_log;
+
+static void test_replay(void)
+{
+    static game_state_t copy;
+    //long enough that the oldest records are folded into the base. A line goal it
+    //never reaches holds the level, so gravity never outruns the autoplayer.
+    core_init(&state, 3);
+    state.goal = 0xFFFFFFFF;
+    replay_init(&replay_log, &state, 3);
+    unsigned int rng = 1, planned = 0;
+    ai_plan_t plan;
+    int next = 0;
+    while(state.pieces < 1500 && !state.game_over) {
+        if(planned != state.pieces + 1) {
+            planned = state.pieces + 1;
+            next = 0;
+            ai_choose_greedy(&state, &plan);
+        }
+        //the autoplayer's moves with a few idle ticks between them
+        rng = rng * 1664525 + 1013904223;
+        input_t input = (rng >> 30) || next >= plan.count ? INPUT_NONE : plan.moves[next++];
+        if(input != INPUT_NONE) {
+            replay_record(&replay_log, &state, input);
+        }
+        core_step(&state, input);
+    }
+    assert(replay_log.head > 0 && replay_log.records > 0);
+    replay_run(&replay_log, &copy, state.tick);
+    assert(copy.tick == state.tick);
+    assert(core_hash(&copy) == core_hash(&state));
+}
+
+static link_t link_a, link_b;
+
+//Carries every byte queued on one link over to the other, flipping one on the way if asked
+static void wire(link_t* from, link_t* to, int corrupt)
+{
+    unsigned char byte;
+    for(int i = 0; link_tx_get(from, &byte); i++) {
+        link_rx_put(to, i == corrupt ? byte ^ 0x10 : byte);
+    }
+}
+
+static void test_link(void)
+{
+    link_init(&link_a, NULL);
+    link_init(&link_b, NULL);
+    link_frame_t f;
+    unsigned char payload[3] = {LINK_SYNC, 2, 3};
+    assert(link_send(&link_a, 5, payload, sizeof(payload)));
+    assert(link_send(&link_a, 6, 0, 0));
+    wire(&link_a, &link_b, -1);
+    assert(link_receive(&link_b, &f));
+    assert(f.type == 5 && f.seq == 0 && f.len == 3);
+    assert(f.payload[0] == LINK_SYNC && f.payload[2] == 3);
+    assert(link_receive(&link_b, &f) && f.type == 6 && f.len == 0);
+    assert(!link_receive(&link_b, &f));
+
+    //a flipped bit costs that frame only, the next one counts it as lost
+    link_send(&link_a, 7, payload, sizeof(payload));
+    wire(&link_a, &link_b, 5);
+    link_send(&link_a, 8, payload, sizeof(payload));
+    wire(&link_a, &link_b, -1);
+    assert(link_receive(&link_b, &f) && f.type == 8);
+    assert(link_b.stats.crc_errors == 1 && link_b.stats.lost == 1);
+
+    //a full tx queue drops whole frames
+    while(link_send(&link_a, 9, payload, sizeof(payload))) {}
+    assert(link_a.stats.dropped == 1);
+}
+
+static void test_garbage(void)
+{
+    core_init(&state, 1);
+    core_queue_garbage(&state, 2, 4);
+    core_queue_garbage(&state, 1, 6);
+    assert(state.garbage == 3);
+    core_step(&state, INPUT_HARD_DROP);
+    //three rows under the locked piece, each full but for the last hole
+    for(int y = HEIGHT - 3; y < HEIGHT; y++) {
+        assert(state.board.rows[y] == (ROW_FULL & ~(1 << (6 + BOARD_PAD))));
+        assert(state.board.cells[y][6] == 0 && state.board.cells[y][0] == CELL_GARBAGE);
+    }
+    assert(state.garbage == 0 && !state.game_over);
+    assert(state.board.height >= 4);
+
+    //more than the stack has room for tops out
+    core_queue_garbage(&state, HEIGHT, 0);
+    core_step(&state, INPUT_HARD_DROP);
+    assert(state.game_over);
+}
+
+#define ROLLBACK_DELAY 5
+#define ROLLBACK_TICKS 1500
+
+static rollback_t sides[2], reference;
+static game_state_t games[6];
+static unsigned char given[2][ROLLBACK_TICKS];
+
+//Two autoplayers whose inputs reach the other side ROLLBACK_DELAY ticks late must end
+//on the same games as a match that knew every input in time
+static void test_rollback(void)
+{
+    static ai_plan_t plans[2];
+    int next[2] = {0, 0};
+    unsigned int planned[2] = {0, 0};
+    rollback_init(&sides[0], &games[0], &games[1], 0, 9);
+    rollback_init(&sides[1], &games[3], &games[2], 1, 9);
+    for(int step = 0; step < ROLLBACK_TICKS + ROLLBACK_DELAY; step++) {
+        for(int p = 0; p < 2; p++) {
+            rollback_t* r = &sides[p];
+            game_state_t* own = r->games[p];
+            r->acked = r->given;
+            if(planned[p] != own->pieces + 1) {
+                planned[p] = own->pieces + 1;
+                next[p] = 0;
+                if(!ai_choose_greedy(own, &plans[p])) {
+                    plans[p].count = 0;
+                }
+            }
+            //the second player only presses every third tick, so the games differ
+            input_t input = (p && r->given % 3) || next[p] >= plans[p].count ? INPUT_NONE : plans[p].moves[next[p]];
+            unsigned int t = r->given;
+            if(t < ROLLBACK_TICKS && rollback_tick(r, input)) {
+                given[p][t] = input;
+                next[p] += input != INPUT_NONE;
+            }
+        }
+        int t = step - ROLLBACK_DELAY;
+        for(int p = 0; p < 2; p++) {
+            if(t >= 0 && t < (int) sides[!p].given) {
+                rollback_receive(&sides[p], t, &given[!p][t], 1);
+            }
+        }
+    }
+    assert(sides[0].tick == sides[1].tick);
+    assert(sides[0].confirmed >= sides[0].tick && sides[1].confirmed >= sides[1].tick);
+    assert(sides[0].stats.rollbacks > 0 && sides[1].stats.deepest >= ROLLBACK_DELAY);
+
+    rollback_init(&reference, &games[4], &games[5], 0, 9);
+    while(reference.tick < sides[0].tick) {
+        unsigned int t = reference.tick;
+        rollback_receive(&reference, t, &given[1][t], 1);
+        reference.acked = reference.given;
+        assert(rollback_tick(&reference, given[0][t]));
+    }
+    assert(reference.stats.rollbacks == 0);
+    for(int g = 0; g < 2; g++) {
+        assert(core_hash(sides[0].games[g]) == core_hash(reference.games[g]));
+        assert(core_hash(sides[1].games[g]) == core_hash(reference.games[g]));
+        //rolled back boards keep the colors of the pieces on them
+        for(int y = 0; y < HEIGHT; y++) {
+            for(int x = 0; x < WIDTH; x++) {
+                assert(sides[0].games[g]->board.cells[y][x] == reference.games[g]->board.cells[y][x]);
+                assert(sides[1].games[g]->board.cells[y][x] == reference.games[g]->board.cells[y][x]);
+            }
+        }
+    }
+    assert(games[1].lines != games[0].lines);
+}
+
+static versus_t players[2];
+static game_state_t versus_games[4];
+
+//Player 1 powers up between two of player 0's hellos, so player 0's first ones are
+//lost and it starts on player 1's hello before sending another. Both must still start
+//one match and play it in step, whichever of them has the lower seed.
+static void versus_staggered(unsigned int seed0, unsigned int seed1)
+{
+    link_init(&link_a, NULL);
+    link_init(&link_b, NULL);
+    versus_init(&players[0], &link_a, &versus_games[0], &versus_games[1], seed0, 0);
+    unsigned int now = 0;
+    for(; now < 2 * RESEND_US + RESEND_US / 2; now += 1000) {
+        versus_update(&players[0], now);
+        unsigned char byte;
+        while(link_tx_get(&link_a, &byte)) {}
+    }
+    versus_init(&players[1], &link_b, &versus_games[2], &versus_games[3], seed1, now);
+    for(int i = 0; i < 200; i++, now += 1000) {
+        for(int p = 0; p < 2; p++) {
+            versus_update(&players[p], now);
+            versus_tick(&players[p], INPUT_NONE);
+        }
+        wire(&link_a, &link_b, -1);
+        wire(&link_b, &link_a, -1);
+    }
+    assert(players[0].started && players[1].started);
+    assert(players[0].seed == players[1].seed);
+    assert(players[0].seed == (seed0 < seed1 ? seed0 : seed1));
+    assert(players[0].rollback.local == (seed0 > seed1));
+    assert(players[1].rollback.local == !players[0].rollback.local);
+    assert(players[0].rollback.confirmed > 100 && players[1].rollback.confirmed > 100);
+}
+
+static void test_versus(void)
+{
+    versus_staggered(10, 5);
+    versus_staggered(5, 10);
+}
 
 void main(void)
 {
     uart_init();
 
     printf("Testing board module.\n");
+    test_tables();
+    test_collides();
+    test_lines();
+    test_counters();
+    test_drop();
+    test_clear();
+    test_rotation();
+    test_gravity();
+    test_events();
+    test_snapshot();
+    test_replay();
+    test_scoring();
+    test_link();
+    test_garbage();
+    test_rollback();
+    test_versus();
     printf("All done!\n");
     uart_putchar(EOT);
 }
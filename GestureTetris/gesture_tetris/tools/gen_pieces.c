@@ -0,0 +1,72 @@
+// Host tool that expands the SRS macros in piece.h into the const geometry
+// tables of piece_tables.c, so the Pi never scans a 4x4 box at runtime.
+// Run by the Makefile whenever piece.h changes.
+#include <stdio.h>
+#include "piece.h"
+
+//same order as piece numbers
+static const char* names = "IZJLOST";
+
+static const rot_state states[NUM_PIECES][4] = {
+  {I_one, I_two, I_three, I_four},
+  {Z_one, Z_two, Z_three, Z_four},
+  {J_one, J_two, J_three, J_four},
+  {L_one, L_two, L_three, L_four},
+  {O_one, O_two, O_three, O_four},
+  {S_one, S_two, S_three, S_four},
+  {T_one, T_two, T_three, T_four},
+};
+
+static int make_geometry(const rot_state state, piece_geometry* g) {
+  int n = 0;
+  g->left = g->top = 3;
+  g->right = g->bottom = 0;
+  for(int x = 0; x < 4; x++) {
+    g->col_bottom[x] = -1;
+  }
+  for(int y = 0; y < 4; y++) {
+    g->rows[y] = 0;
+    for(int x = 0; x < 4; x++) {
+      if(state[y][x]) {
+        if(n == 4) {
+          return -1;
+        }
+        g->cells[n][0] = x;
+        g->cells[n][1] = y;
+        n++;
+        g->rows[y] |= 1 << x;
+        g->col_bottom[x] = y;
+        if(x < g->left) g->left = x;
+        if(x > g->right) g->right = x;
+        if(y < g->top) g->top = y;
+        if(y > g->bottom) g->bottom = y;
+      }
+    }
+  }
+  return n;
+}
+
+int main(void) {
+  printf("// Generated by tools/gen_pieces.c from the SRS macros in piece.h, do not edit.\n");
+  printf("#include \"piece.h\"\n\n");
+  printf("const piece_geometry piece_table[NUM_PIECES][4] = {\n");
+  for(int num = 0; num < NUM_PIECES; num++) {
+    printf("  { //%c\n", names[num]);
+    for(int rot = 0; rot < 4; rot++) {
+      piece_geometry g;
+      if(make_geometry(states[num][rot], &g) != 4) {
+        fprintf(stderr, "gen_pieces: %c rotation %d does not have 4 cells\n", names[num], rot);
+        return 1;
+      }
+      printf("    {{{%d, %d}, {%d, %d}, {%d, %d}, {%d, %d}}, %d, %d, %d, %d, {%d, %d, %d, %d}, {0x%x, 0x%x, 0x%x, 0x%x}},\n",
+        g.cells[0][0], g.cells[0][1], g.cells[1][0], g.cells[1][1],
+        g.cells[2][0], g.cells[2][1], g.cells[3][0], g.cells[3][1],
+        g.left, g.right, g.top, g.bottom,
+        g.col_bottom[0], g.col_bottom[1], g.col_bottom[2], g.col_bottom[3],
+        g.rows[0], g.rows[1], g.rows[2], g.rows[3]);
+    }
+    printf("  },\n");
+  }
+  printf("};\n");
+  return 0;
+}
@@ -0,0 +1,205 @@
+#include "versus.h"
+#include "printf.h"
+
+//payloads are little endian whatever the two ends are
+static void put32(unsigned char* p, unsigned int value) {
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+}
+
+static unsigned int get32(const unsigned char* p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int) p[3] << 24;
+}
+
+//The games start once the other side's hello comes in, until then they are left alone
+void versus_init(versus_t* v, link_t* link, game_state_t* local_game, game_state_t* remote_game,
+  unsigned int seed, unsigned int now_us) {
+  v->link = link;
+  v->local_game = local_game;
+  v->remote_game = remote_game;
+  v->started = v->heard = false;
+  v->own_seed = v->seed = seed;
+  v->sent = v->ack_sent = 0;
+  v->last_send_us = now_us - RESEND_US;
+  v->remote_lead = 0;
+  v->waits = v->next_wait = 0;
+  v->next_heartbeat = 0;
+  v->start_us = now_us;
+  v->latency_samples = v->latency_max = 0;
+  v->latency_min = 0xFFFFFFFF;
+  v->latency_total = 0;
+}
+
+//Runs the match a tick with the local input, or returns false if the tick has to be
+//waited out: before the start, while rollback waits, or now and then while this side
+//is further ahead of the other than the other is of it
+bool versus_tick(versus_t* v, input_t input) {
+  if(!v->started) {
+    return false;
+  }
+  rollback_t* r = &v->rollback;
+  int lead = r->given - r->confirmed;
+  if(lead - v->remote_lead >= 2 && r->tick >= v->next_wait) {
+    v->next_wait = r->tick + SYNC_TICKS;
+    v->waits++;
+    return false;
+  }
+  return rollback_tick(r, input);
+}
+
+//Inputs from start on, with the ack for the other side's and how far ahead this side is
+static void send_inputs(versus_t* v, unsigned int start, unsigned int now_us) {
+  rollback_t* r = &v->rollback;
+  int count = r->given - start;
+  if(count > INPUTS_PER_FRAME) {
+    count = INPUTS_PER_FRAME;
+  }
+  unsigned char payload[LINK_MAX_PAYLOAD] = {0};
+  put32(payload, start);
+  put32(payload + 4, r->confirmed);
+  payload[8] = r->given - r->confirmed;
+  payload[9] = count;
+  for(int i = 0; i < count; i++) {
+    payload[10 + i / 2] |= rollback_local_input(r, start + i) << (i % 2 * 4);
+  }
+  if(link_send(v->link, MSG_INPUTS, payload, 10 + (count + 1) / 2)) {
+    v->last_send_us = now_us;
+    v->ack_sent = r->confirmed;
+    if(start + count > v->sent) {
+      v->sent = start + count;
+    }
+  }
+}
+
+static void receive_inputs(versus_t* v, const link_frame_t* f) {
+  rollback_t* r = &v->rollback;
+  int count = f->payload[9];
+  if(f->len < 10 || count > INPUTS_PER_FRAME || f->len != 10 + (count + 1) / 2) {
+    return;
+  }
+  unsigned int ack = get32(f->payload + 4);
+  if(ack > r->acked && ack <= r->given) {
+    r->acked = ack;
+  }
+  v->remote_lead = (signed char) f->payload[8];
+  v->heard = true;
+  unsigned char inputs[INPUTS_PER_FRAME];
+  for(int i = 0; i < count; i++) {
+    inputs[i] = f->payload[10 + i / 2] >> (i % 2 * 4) & 0xF;
+  }
+  rollback_receive(r, get32(f->payload), inputs, count);
+}
+
+//Equal seeds would leave both sides player 0, with the timer as the seed they never are.
+//Only own_seed is compared, the side that starts first goes on sending it.
+static void receive_hello(versus_t* v, const link_frame_t* f) {
+  unsigned int seed = get32(f->payload);
+  if(v->started || f->len != 4 || seed == v->own_seed) {
+    return;
+  }
+  int local = v->own_seed > seed;
+  v->seed = local ? seed : v->own_seed;
+  rollback_init(&v->rollback, v->local_game, v->remote_game, local, v->seed);
+  v->started = true;
+}
+
+static void receive(versus_t* v, const link_frame_t* f, unsigned int now_us) {
+  switch (f->type) {
+    case MSG_HEARTBEAT:
+      //straight back with the sender's own timestamp
+      if(f->len == 4) {
+        link_send(v->link, MSG_ECHO, f->payload, 4);
+      }
+      break;
+    case MSG_ECHO: {
+      if(f->len != 4) {
+        break;
+      }
+      unsigned int one_way = (now_us - get32(f->payload)) / 2;
+      v->latency_samples++;
+      v->latency_total += one_way;
+      if(one_way < v->latency_min) {
+        v->latency_min = one_way;
+      }
+      if(one_way > v->latency_max) {
+        v->latency_max = one_way;
+      }
+      break;
+    }
+    case MSG_HELLO:
+      receive_hello(v, f);
+      break;
+    case MSG_INPUTS:
+      if(v->started) {
+        receive_inputs(v, f);
+      }
+      break;
+  }
+}
+
+//Handles every frame that came in and sends what is due: new inputs as soon as there
+//are any, the unacked ones again after RESEND_US, and the hello until the other side
+//is heard from. Never waits on the link, call it as often as the loop comes around.
+void versus_update(versus_t* v, unsigned int now_us) {
+  link_frame_t f;
+  while(link_receive(v->link, &f)) {
+    receive(v, &f, now_us);
+  }
+  bool resend = now_us - v->last_send_us >= RESEND_US;
+  if(!v->heard && resend) {
+    unsigned char payload[4];
+    put32(payload, v->own_seed);
+    if(link_send(v->link, MSG_HELLO, payload, sizeof(payload))) {
+      v->last_send_us = now_us;
+    }
+  }
+  if(!v->started) {
+    return;
+  }
+  rollback_t* r = &v->rollback;
+  if(r->given > v->sent) {
+    send_inputs(v, r->given - r->acked > INPUTS_PER_FRAME ? r->given - INPUTS_PER_FRAME : r->acked, now_us);
+  } else if((r->acked < r->given && resend) || r->confirmed != v->ack_sent) {
+    send_inputs(v, r->acked, now_us);
+  }
+  if(r->tick >= v->next_heartbeat) {
+    v->next_heartbeat = r->tick + HEARTBEAT_TICKS;
+    unsigned char payload[4];
+    put32(payload, now_us);
+    link_send(v->link, MSG_HEARTBEAT, payload, sizeof(payload));
+  }
+}
+
+bool versus_over(const versus_t* v) {
+  return v->started && rollback_over(&v->rollback);
+}
+
+//The other side has every local input, so it can settle the match too
+bool versus_flushed(const versus_t* v) {
+  return v->started && v->rollback.acked >= v->rollback.given;
+}
+
+void versus_print(const versus_t* v, unsigned int now_us) {
+  const link_stats_t* s = &v->link->stats;
+  const rollback_t* r = &v->rollback;
+  unsigned int elapsed_ms = (now_us - v->start_us) / 1000;
+  if(!elapsed_ms) {
+    elapsed_ms = 1;
+  }
+  bool lost = v->local_game->game_over, won = v->remote_game->game_over;
+  printf("%s\n", !v->started ? "NOT STARTED" : lost && won ? "DRAW" : lost ? "LOST" : won ? "WON" : "NO RESULT");
+  printf("player %d, %d ticks, lines %d to %d\n", r->local, r->tick, v->local_game->lines, v->remote_game->lines);
+  printf("rollbacks %d deepest %d resimulated %d stalls %d waits %d\n", r->stats.rollbacks,
+    r->stats.deepest, r->stats.resimulated, r->stats.stalls, v->waits);
+  printf("frames sent %d received %d lost %d bad %d dropped %d\n", s->frames_sent,
+    s->frames_received, s->lost, s->crc_errors, s->dropped);
+  printf("bytes/s sent %d received %d over %d ms\n",
+    (int) ((unsigned long long) s->bytes_sent * 1000 / elapsed_ms),
+    (int) ((unsigned long long) s->bytes_received * 1000 / elapsed_ms), elapsed_ms);
+  if(v->latency_samples) {
+    printf("one-way latency us min %d avg %d max %d over %d samples\n", v->latency_min,
+      (int) (v->latency_total / v->latency_samples), v->latency_max, v->latency_samples);
+  }
+}
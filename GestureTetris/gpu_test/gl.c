@@ -1,25 +1,44 @@
 #include "gl.h"
+#include "glextra.h"
 #include "fb.h"
 #include "font.h"
+#include "malloc.h"
 
 int min(int a, int b);
 
+// Where drawing goes: the framebuffer's draw buffer, or a surface after
+// gl_set_target. The framebuffer's size never changes after gl_init, so it
+// is read once there rather than through fb_get_* on every primitive. Pitch
+// is in words.
 static void* framebuffer;
+static int draw_width, draw_height, draw_pitch;
+static gl_surface_t *target;
+
+static void target_framebuffer(void)
+{
+    framebuffer = fb_get_draw_buffer();
+    draw_width = fb_get_width();
+    draw_height = fb_get_height();
+    draw_pitch = fb_get_pitch() / 4;
+}
 
 void gl_init(unsigned int width, unsigned int height, gl_mode_t mode)
 {
     fb_init(width, height, 4, mode);    // use 32-bit depth always for graphics library
-    framebuffer = fb_get_draw_buffer();
+    target = NULL;
+    target_framebuffer();
 }
 
 static inline const int in_bounds(int x, int y) {
-  return x >= 0 && x < gl_get_width() && y >= 0 && y < gl_get_height();
+  return x >= 0 && x < draw_width && y >= 0 && y < draw_height;
 }
 
 void gl_swap_buffer(void)
 {
     fb_swap_buffer();
-    framebuffer = fb_get_draw_buffer();
+    if (!target) {
+        framebuffer = fb_get_draw_buffer();
+    }
 }
 
 unsigned int gl_get_width(void)
@@ -37,16 +56,84 @@ color_t gl_color(unsigned char r, unsigned char g, unsigned char b)
     return (0xff << 24) + (r << 16) + (g << 8) + b;
 }
 
+// Fills n words from dst. Stores go out 8 words at a time once dst is on a
+// 32-byte boundary, as one store-multiple on the Pi, which the write buffer
+// turns into a single burst.
+static void fill_span(unsigned int *dst, int n, color_t c)
+{
+    while (n > 0 && ((unsigned long)dst & 31)) {
+        *dst++ = c;
+        n--;
+    }
+    if (n >= 8) {
+        unsigned int *end = dst + (n & ~7);
+#ifdef __arm__
+        register unsigned int c0 asm("r2") = c, c1 asm("r3") = c, c2 asm("r4") = c, c3 asm("r5") = c;
+        register unsigned int c4 asm("r6") = c, c5 asm("r7") = c, c6 asm("r8") = c, c7 asm("r9") = c;
+        asm volatile("1: stmia %0!, {r2-r9}\n"
+                     "   cmp %0, %1\n"
+                     "   blo 1b"
+                     : "+r"(dst)
+                     : "r"(end), "r"(c0), "r"(c1), "r"(c2), "r"(c3), "r"(c4), "r"(c5), "r"(c6), "r"(c7)
+                     : "cc", "memory");
+#else
+        for (; dst < end; dst += 8) {
+            dst[0] = dst[1] = dst[2] = dst[3] = dst[4] = dst[5] = dst[6] = dst[7] = c;
+        }
+#endif
+        n &= 7;
+    }
+    while (n-- > 0) {
+        *dst++ = c;
+    }
+}
+
+// Copies n words from src to dst, 8 words per load-multiple and store-multiple
+// once dst is on a 32-byte boundary. The framebuffer is the destination, so its
+// alignment is the one that decides the bursts.
+static void copy_span(unsigned int *dst, const unsigned int *src, int n)
+{
+    while (n > 0 && ((unsigned long)dst & 31)) {
+        *dst++ = *src++;
+        n--;
+    }
+    if (n >= 8) {
+        unsigned int *end = dst + (n & ~7);
+#ifdef __arm__
+        asm volatile("1: ldmia %1!, {r2-r9}\n"
+                     "   stmia %0!, {r2-r9}\n"
+                     "   cmp %0, %2\n"
+                     "   blo 1b"
+                     : "+r"(dst), "+r"(src)
+                     : "r"(end)
+                     : "r2", "r3", "r4", "r5", "r6", "r7", "r8", "r9", "cc", "memory");
+#else
+        for (; dst < end; dst += 8, src += 8) {
+            dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3];
+            dst[4] = src[4]; dst[5] = src[5]; dst[6] = src[6]; dst[7] = src[7];
+        }
+#endif
+        n &= 7;
+    }
+    while (n-- > 0) {
+        *dst++ = *src++;
+    }
+}
+
 void gl_clear(color_t c)
 {
-    gl_draw_rect(0, 0, gl_get_width(), gl_get_height(), c);
+    if (draw_pitch == draw_width) {
+        // rows follow one another with no padding, so the buffer is one span
+        fill_span(framebuffer, draw_width * draw_height, c);
+    } else {
+        gl_draw_rect(0, 0, draw_width, draw_height, c);
+    }
 }
 
 void gl_draw_pixel(int x, int y, color_t c)
 {
     if(in_bounds(x, y)) {
-       int width = fb_get_pitch() / 4;
-       unsigned int (*pixels)[width] = (unsigned int (*)[width]) framebuffer;
+       unsigned int (*pixels)[draw_pitch] = (unsigned int (*)[draw_pitch]) framebuffer;
        pixels[y][x] = c;
     }
 }
@@ -54,25 +141,25 @@ void gl_draw_pixel(int x, int y, color_t c)
 color_t gl_read_pixel(int x, int y)
 {
     if(in_bounds(x, y)) {
-       int width = fb_get_pitch() / 4;
-       unsigned int (*pixels)[width] = (unsigned int (*)[width]) framebuffer;
+       unsigned int (*pixels)[draw_pitch] = (unsigned int (*)[draw_pitch]) framebuffer;
        return pixels[y][x];
     }
     return 0;
 }
 
+// Clipped to the framebuffer, then filled a row at a time so the stores walk
+// memory in order
 void gl_draw_rect(int x, int y, int w, int h, color_t c)
 {
-    if(in_bounds(x, y)) {
-      int width = fb_get_pitch() / 4;
-      unsigned int (*pixels)[width] = (unsigned int (*)[width]) framebuffer;
-      int xBound = min(x + w, gl_get_width());
-      int yBound = min(y + h, gl_get_height());
-      for(int xPos = x; xPos < xBound; xPos++) {
-        for(int yPos = y; yPos < yBound; yPos++) {
-          pixels[yPos][xPos] = c;
-        }
-      }
+    int xBound = min(x + w, draw_width);
+    int yBound = min(y + h, draw_height);
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x >= xBound || y >= yBound) return;
+    unsigned int *row = (unsigned int *)framebuffer + y * draw_pitch + x;
+    for (int yPos = y; yPos < yBound; yPos++) {
+      fill_span(row, xBound - x, c);
+      row += draw_pitch;
     }
 }
 
@@ -111,3 +198,96 @@ unsigned int gl_get_char_width(void)
 {
     return font_get_width();
 }
+
+// Surface rows start on 32-byte boundaries, so whole rows go out in bursts.
+// The surface and its pixels share one allocation.
+gl_surface_t *gl_surface_create(int width, int height)
+{
+    if (width <= 0 || height <= 0) return NULL;
+    int pitch = (width + 7) & ~7;
+    gl_surface_t *s = malloc(sizeof(gl_surface_t) + 31 + pitch * height * sizeof(color_t));
+    if (!s) return NULL;
+    char *pixels = (char *)(s + 1);
+    s->pixels = (color_t *)(pixels + ((32 - ((unsigned long)pixels & 31)) & 31));
+    s->width = width;
+    s->height = height;
+    s->pitch = pitch * sizeof(color_t);
+    s->transparent = false;
+    s->transparent_color = 0;
+    return s;
+}
+
+void gl_surface_free(gl_surface_t *s)
+{
+    if (s == target) {
+        gl_set_target(NULL);
+    }
+    free(s);
+}
+
+void gl_set_target(gl_surface_t *s)
+{
+    target = s;
+    if (s) {
+        framebuffer = s->pixels;
+        draw_width = s->width;
+        draw_height = s->height;
+        draw_pitch = s->pitch / 4;
+    } else {
+        target_framebuffer();
+    }
+}
+
+// Copies a row, leaving pixels of the transparent color alone. Each run of
+// other pixels still goes through copy_span.
+static void copy_keyed(unsigned int *dst, const unsigned int *src, int n, color_t key)
+{
+    int i = 0;
+    while (i < n) {
+        while (i < n && src[i] == key) i++;
+        int start = i;
+        while (i < n && src[i] != key) i++;
+        copy_span(dst + start, src + start, i - start);
+    }
+}
+
+// Copies a w by h block at (sx, sy) in src to (x, y) in pixels, which are
+// width by height with pitch words to a row. The block is clipped to both.
+static void blit(unsigned int *pixels, int width, int height, int pitch, int x, int y,
+                 const gl_surface_t *src, int sx, int sy, int w, int h)
+{
+    if (sx < 0) { x -= sx; w += sx; sx = 0; }
+    if (sy < 0) { y -= sy; h += sy; sy = 0; }
+    if (x < 0) { sx -= x; w += x; x = 0; }
+    if (y < 0) { sy -= y; h += y; y = 0; }
+    w = min(w, min(src->width - sx, width - x));
+    h = min(h, min(src->height - sy, height - y));
+    if (w <= 0 || h <= 0) return;
+    int src_pitch = src->pitch / 4;
+    const unsigned int *from = src->pixels + sy * src_pitch + sx;
+    unsigned int *to = pixels + y * pitch + x;
+    for (int row = 0; row < h; row++) {
+      if (src->transparent) {
+        copy_keyed(to, from, w, src->transparent_color);
+      } else {
+        copy_span(to, from, w);
+      }
+      from += src_pitch;
+      to += pitch;
+    }
+}
+
+void gl_blit(gl_surface_t *dst, int x, int y, const gl_surface_t *src, int sx, int sy, int w, int h)
+{
+    if (dst) {
+        blit(dst->pixels, dst->width, dst->height, dst->pitch / 4, x, y, src, sx, sy, w, h);
+    } else {
+        blit(framebuffer, draw_width, draw_height, draw_pitch, x, y, src, sx, sy, w, h);
+    }
+}
+
+void gl_draw_image(int x, int y, int w, int h, const color_t *pixels)
+{
+    gl_surface_t image = { w, h, w * sizeof(color_t), (color_t *)pixels, false, 0 };
+    gl_blit(NULL, x, y, &image, 0, 0, w, h);
+}
@@ -0,0 +1,58 @@
+#ifndef GLEXTRA_H
+#define GLEXTRA_H
+
+#include <stdbool.h>
+#include "gl.h"
+
+/*
+ * An off-screen image in the framebuffer's 32-bit format. `pitch` is the
+ * number of bytes from one row to the next and may be more than
+ * width * 4. A surface with `transparent` set is blitted without its
+ * pixels of `transparent_color`, which leaves the destination showing
+ * through.
+ */
+typedef struct {
+    int width;
+    int height;
+    int pitch;
+    color_t *pixels;
+    bool transparent;
+    color_t transparent_color;
+} gl_surface_t;
+
+/*
+ * Allocates a width by height surface from the heap, or returns NULL if
+ * there is not enough memory. Its pixels start out undefined, so
+ * gl_clear it while it is the target before use. Blits are opaque until
+ * `transparent` is set.
+ */
+gl_surface_t *gl_surface_create(int width, int height);
+
+/*
+ * Frees a surface from gl_surface_create. If it is the target, drawing
+ * goes back to the framebuffer.
+ */
+void gl_surface_free(gl_surface_t *s);
+
+/*
+ * Sends every gl drawing call, gl_clear and gl_draw_string included, to
+ * surface `s`. Pass NULL to draw into the framebuffer's draw buffer
+ * again. gl_get_width and gl_get_height always report the framebuffer.
+ */
+void gl_set_target(gl_surface_t *s);
+
+/*
+ * Copies the w by h block at (sx, sy) in `src` to (x, y) in `dst`, or
+ * into the current target if `dst` is NULL. The block is clipped to both
+ * surfaces. Rows are copied 8 words at a time, skipping src's
+ * transparent color if it has one. `src` and `dst` must not overlap.
+ */
+void gl_blit(gl_surface_t *dst, int x, int y, const gl_surface_t *src, int sx, int sy, int w, int h);
+
+/*
+ * Draws a w by h image at (x, y) into the current target, clipped to it.
+ * `pixels` holds the image row after row, w colors to a row.
+ */
+void gl_draw_image(int x, int y, int w, int h, const color_t *pixels);
+
+#endif
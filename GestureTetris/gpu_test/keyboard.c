@@ -1,6 +1,7 @@
 #include "gpio.h"
 #include "gpioextra.h"
 #include "keyboard.h"
+#include "keyboardextra.h"
 #include "ps2.h"
 #include "printf.h"
 #include "interrupts.h"
@@ -17,6 +18,8 @@ static unsigned int CLK, DATA;
 static keyboard_modifiers_t modifiers = 0;
 static struct scanner_state scanner;
 rb_t* ringbuffer;
+//a release prefix was read and the rest of its sequence has not come in yet
+static bool pending_release;
 
 static void clear_scan_state(void) {
   scanner.scancode = 0;
@@ -83,19 +86,27 @@ unsigned char keyboard_read_scancode(void)
   return scancode;
 }
 
-key_action_t keyboard_read_sequence(void)
+//Takes a sequence one scancode at a time, returning true with the action once one
+//ends it. The prefixes before that are remembered across calls.
+static bool decode_scancode(unsigned char scancode, key_action_t* action)
 {
-    key_action_t action;
-    unsigned char scancode = keyboard_read_scancode();
     if(scancode == PS2_CODE_EXTENDED) {
-      action = keyboard_read_sequence();
-    } else if(scancode == PS2_CODE_RELEASE) {
-      action = keyboard_read_sequence();
-      action.what = KEY_RELEASE;
-    } else {
-      action.what = KEY_PRESS;
-      action.keycode = scancode;
+      return false;
+    }
+    if(scancode == PS2_CODE_RELEASE) {
+      pending_release = true;
+      return false;
     }
+    action->what = pending_release ? KEY_RELEASE : KEY_PRESS;
+    action->keycode = scancode;
+    pending_release = false;
+    return true;
+}
+
+key_action_t keyboard_read_sequence(void)
+{
+    key_action_t action;
+    while(!decode_scancode(keyboard_read_scancode(), &action));
     return action;
 }
 
@@ -132,10 +143,10 @@ int isAlpha(ps2_key_t key) {
   return key.ch >= 'a' && key.ch <= 'z';
 }
 
-key_event_t keyboard_read_event(void)
+static key_event_t make_event(key_action_t action)
 {
     key_event_t event;
-    event.action = keyboard_read_sequence();
+    event.action = action;
     event.key = ps2_keys[event.action.keycode];
     if(isMod(event.key)) {
       set_modifers(event.action);
@@ -144,6 +155,24 @@ key_event_t keyboard_read_event(void)
     return event;
 }
 
+key_event_t keyboard_read_event(void)
+{
+    return make_event(keyboard_read_sequence());
+}
+
+bool keyboard_poll_event(key_event_t* event)
+{
+    int scancode;
+    key_action_t action;
+    while(rb_dequeue(ringbuffer, &scancode)) {
+      if(decode_scancode(scancode, &action)) {
+        *event = make_event(action);
+        return true;
+      }
+    }
+    return false;
+}
+
 unsigned char keyboard_read_next(void)
 {
     key_event_t event = keyboard_read_event();
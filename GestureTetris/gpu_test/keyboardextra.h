@@ -0,0 +1,17 @@
+#ifndef KEYBOARDEXTRA_H
+#define KEYBOARDEXTRA_H
+
+#include <stdbool.h>
+#include "keyboard.h"
+
+/*
+ * Reads the next key event without waiting. Returns false if no whole
+ * sequence has been queued yet. Scancodes of a sequence that is still
+ * coming in are taken from the queue and remembered, so a later call
+ * finishes it. Lets a main loop poll the keyboard instead of blocking in
+ * keyboard_read_next, even when the rest of an E0 or F0 sequence is late
+ * or was dropped for bad parity.
+ */
+bool keyboard_poll_event(key_event_t *event);
+
+#endif